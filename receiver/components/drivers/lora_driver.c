@@ -1,9 +1,23 @@
 #include "lora_driver.h"
+#include "airtime.h"
+#include "hop.h"
+#include "crc16.h"
+#include "fec.h"
 #include "driver/spi_master.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_sleep.h"
+#include "nvs.h"
+#include "esp_rom_sys.h"
+#include "esp_random.h"
+#include "hal/gpio_ll.h"
+#include "soc/gpio_struct.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
+#include <stdlib.h>
 #include <string.h>
 
 static const char *TAG = "LORA_SX1262";
@@ -35,65 +49,651 @@ static spi_device_handle_t s_spi = NULL;
 #define CMD_SET_DIO3_AS_TCXO     0x97
 #define CMD_CALIBRATE            0x89
 #define CMD_CALIBRATE_IMAGE      0x98
+#define CMD_GET_STATUS           0xC0
+#define CMD_SET_CAD_PARAMS       0x88
+#define CMD_SET_CAD              0xC5
+#define CMD_SET_RX_DUTY_CYCLE    0x94
+#define CMD_STOP_TIMER_ON_PREAMBLE 0x9F
 
 /* IRQ bit masks */
 #define IRQ_TX_DONE              (1 << 0)
 #define IRQ_RX_DONE              (1 << 1)
+#define IRQ_HEADER_ERR           (1 << 5)
+#define IRQ_CRC_ERR              (1 << 6)
+#define IRQ_CAD_DONE             (1 << 7)
+#define IRQ_CAD_DETECTED         (1 << 8)
 #define IRQ_TIMEOUT              (1 << 9)
 
 /* LoRa sync word register address */
 #define REG_SYNC_WORD_MSB        0x0740
 
-/* Last packet RSSI */
-static int s_last_rssi = 0;
+/* NRESET low time; the chip then holds BUSY until it is ready */
+#define SX_RESET_PULSE_US        200
+
+/* Packet params for the selected profile */
+#define PKT_HEADER_EXPLICIT      0x00
+#define PKT_HEADER_IMPLICIT      0x01
+
+#if LORA_PROFILE == LORA_PROFILE_LOW_AIRTIME
+#define PKT_PREAMBLE             LORA_LOW_AIRTIME_PREAMBLE
+#define PKT_HEADER_TYPE          PKT_HEADER_IMPLICIT
+#define PKT_RX_LENGTH            LORA_IMPLICIT_PACKET_SIZE
+#else
+#define PKT_PREAMBLE             LORA_STANDARD_PREAMBLE
+#define PKT_HEADER_TYPE          PKT_HEADER_EXPLICIT
+#define PKT_RX_LENGTH            LORA_MAX_PACKET_SIZE
+#endif
+
+/* Duty-cycled receive stretches the preamble on the side that needs it */
+#if LORA_LONG_PREAMBLE
+#define PKT_TX_PREAMBLE          LORA_WAKE_PREAMBLE
+#else
+#define PKT_TX_PREAMBLE          PKT_PREAMBLE
+#endif
+
+#if LORA_RX_DUTY_CYCLE || LORA_HOP_SCAN
+#define PKT_RX_PREAMBLE          LORA_WAKE_PREAMBLE
+#else
+#define PKT_RX_PREAMBLE          PKT_PREAMBLE
+#endif
+
+/* SetRxDutyCycle periods count 15.625 us steps, 24 bits */
+#define SX_RXDC_STEPS(us)        ((uint32_t)(((uint64_t)(us) * 64) / 1000))
+
+/* Start-up before each listen window: the TCXO delay from the init
+ * table (0x40 steps of 15.625 us) */
+#define SX_RXDC_WAKE_US          1000
+
+/* Time of the last DIO1 edge outside TX: RX_DONE for a received frame */
+static volatile int64_t s_rx_irq_us = 0;
+
+/* IRQ bits lora_driver_available() found with RX_DONE, cleared on readout */
+static uint16_t s_rx_irq_bits = 0;
+
+/* RX_DONE to re-armed / read out */
+static lora_rx_timing_t s_rx_timing;
+
+/* Frames the radio received with a bad payload CRC, dropped unread */
+static uint32_t s_rx_crc_errors = 0;
+
+/* Configuration the radio is running with */
+static lora_radio_config_t s_config = LORA_RADIO_CONFIG_DEFAULT;
+
+/* Task woken by the DIO1 ISR (last caller of lora_driver_wait_irq) */
+static TaskHandle_t s_irq_task = NULL;
+
+/* Async TX: one frame in flight, its result posted by the DIO1 ISR */
+static QueueHandle_t  s_tx_done = NULL;
+static volatile bool  s_tx_in_flight = false;
+static uint8_t        s_tx_length;
+static int64_t        s_tx_start_us;
+static int64_t        s_tx_deadline_us;
+
+/* Listen-before-talk counters */
+static lora_lbt_stats_t s_lbt;
+
+/* Plan channel the radio is tuned to; the channel scan's position */
+static uint8_t s_channel = LORA_CHANNEL_NONE;
+#if LORA_HOP_SCAN
+static uint8_t s_scan_channel = 0;
+#endif
+static lora_hop_stats_t s_hop;
+
+/* SET_SLEEP issued: BUSY stays high until an NSS edge wakes the chip */
+static bool s_asleep = false;
+
+/* Signature of the configuration the radio kept in warm-start sleep,
+ * 0 if it was not put to sleep (survives deep sleep, cleared at power-on) */
+#define SX_WARM_MAGIC            0x5357
+static RTC_DATA_ATTR uint32_t s_rtc_config_sig = 0;
+
+/* Task sleeping on the BUSY falling edge, NULL when nobody waits */
+static TaskHandle_t s_busy_task = NULL;
+
+/* Command whose processing the next BUSY wait is charged to */
+#define BUSY_OP_NONE             0xFF
+static uint8_t s_last_opcode = BUSY_OP_NONE;
+
+#if LORA_BUSY_STATS
+static lora_busy_stats_t s_busy_stats[LORA_BUSY_STATS_SLOTS];
+static uint8_t s_busy_stats_used = 0;
+
+/* Upper bound (exclusive) of each histogram bucket; last is open-ended */
+static const uint32_t s_busy_bucket_us[LORA_BUSY_HIST_BUCKETS - 1] = {
+    10, 100, 1000, 10000,
+};
+#endif
+
+/* Longest transaction is READ_BUFFER: opcode + offset + NOP + payload,
+ * rounded up to whole words so DMA never needs a bounce buffer */
+#define SX_SCRATCH_SIZE          ((3 + LORA_MAX_PACKET_SIZE + 3) & ~3)
+
+/* DMA-capable scratch for transactions longer than 4 bytes. The driver
+ * is only driven from one radio task, so a single pair is enough. */
+static DMA_ATTR uint8_t s_spi_tx[SX_SCRATCH_SIZE];
+static DMA_ATTR uint8_t s_spi_rx[SX_SCRATCH_SIZE];
+
+/* Blocking time in ticks, rounded up, plus one because the first tick
+ * may be about to fire. At CONFIG_FREERTOS_HZ=100 pdMS_TO_TICKS() turns
+ * any wait under 10 ms (a CAD, an SF7 frame's tail) into no wait at all. */
+static TickType_t sx_ticks(uint32_t ms)
+{
+    if (ms == portMAX_DELAY) {
+        return portMAX_DELAY;
+    }
+    return (TickType_t)((ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS) + 1;
+}
 
 /* ─── SPI Low Level ───────────────────────────────────────────── */
 
-static void wait_busy(void)
+#if LORA_BUSY_STATS
+/* Entry for `opcode`, allocated on first use; NULL once the table is full */
+static lora_busy_stats_t *busy_stats_slot(uint8_t opcode)
+{
+    for (uint8_t i = 0; i < s_busy_stats_used; i++) {
+        if (s_busy_stats[i].opcode == opcode) {
+            return &s_busy_stats[i];
+        }
+    }
+    if (s_busy_stats_used == LORA_BUSY_STATS_SLOTS) {
+        return NULL;
+    }
+    lora_busy_stats_t *st = &s_busy_stats[s_busy_stats_used++];
+    st->opcode = opcode;
+    return st;
+}
+
+static void busy_stats_record(uint8_t opcode, uint32_t us)
+{
+    lora_busy_stats_t *st = busy_stats_slot(opcode);
+    if (st == NULL) {
+        return;
+    }
+
+    uint8_t bucket = 0;
+    while (bucket < LORA_BUSY_HIST_BUCKETS - 1 && us >= s_busy_bucket_us[bucket]) {
+        bucket++;
+    }
+
+    st->count++;
+    st->total_us += us;
+    st->hist[bucket]++;
+    if (us > st->max_us) {
+        st->max_us = us;
+    }
+}
+#endif
+
+static void IRAM_ATTR busy_isr_handler(void *arg)
+{
+    (void)arg;
+    BaseType_t woken = pdFALSE;
+    TaskHandle_t task = s_busy_task;
+
+    if (task != NULL) {
+        vTaskNotifyGiveFromISR(task, &woken);
+    }
+    portYIELD_FROM_ISR(woken);
+}
+
+/* Slow path: sleep until the BUSY falling edge (calibration, wake-up) */
+static void wait_busy_edge(int64_t start)
 {
-    int retries = 0;
+    s_busy_task = xTaskGetCurrentTaskHandle();
+    gpio_intr_enable(LORA_PIN_BUSY);
+
+    /* Re-check the level after enabling so an edge in between is not lost */
     while (gpio_get_level(LORA_PIN_BUSY) == 1) {
-        vTaskDelay(pdMS_TO_TICKS(1));
-        if (++retries > 1000) {
+        int64_t waited_ms = (esp_timer_get_time() - start) / 1000;
+        if (waited_ms >= LORA_BUSY_TIMEOUT_MS) {
             ESP_LOGE(TAG, "BUSY pin timeout!");
             break;
         }
+        ulTaskNotifyTake(pdTRUE, sx_ticks(LORA_BUSY_TIMEOUT_MS - waited_ms));
     }
+
+    gpio_intr_disable(LORA_PIN_BUSY);
+    s_busy_task = NULL;
 }
 
-static void sx_cmd(const uint8_t *cmd, size_t cmd_len,
-                   uint8_t *resp, size_t resp_len)
+/* Wake from sleep: the NSS falling edge of any command does it, and the
+ * command itself is discarded. BUSY then drops once in STDBY_RC. */
+static void sx_wakeup(void)
 {
-    wait_busy();
+    spi_transaction_t t = {
+        .flags  = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA,
+        .length = 16,
+    };
+    t.tx_data[0] = CMD_GET_STATUS;
+    t.tx_data[1] = 0x00;
+    spi_device_polling_transmit(s_spi, &t);
 
-    size_t total = cmd_len + resp_len;
-    uint8_t *tx = calloc(total, 1);
-    uint8_t *rx = calloc(total, 1);
-    if (!tx || !rx) { free(tx); free(rx); return; }
+    s_asleep = false;
+    s_last_opcode = CMD_GET_STATUS;
+}
+
+/* Wait for BUSY low before sending `opcode`: spin briefly, then sleep.
+ * The wait is charged to the previous command. */
+static void wait_busy(uint8_t opcode)
+{
+    if (s_asleep) {
+        sx_wakeup();
+    }
+
+    int64_t start = esp_timer_get_time();
+
+    while (gpio_get_level(LORA_PIN_BUSY) == 1) {
+        if (esp_timer_get_time() - start >= LORA_BUSY_SPIN_US) {
+            wait_busy_edge(start);
+            break;
+        }
+        esp_rom_delay_us(1);
+    }
+
+#if LORA_BUSY_STATS
+    if (s_last_opcode != BUSY_OP_NONE) {
+        busy_stats_record(s_last_opcode, (uint32_t)(esp_timer_get_time() - start));
+    }
+#endif
+    s_last_opcode = opcode;
+}
 
-    memcpy(tx, cmd, cmd_len);
+/* Clock out `total` bytes from s_spi_tx; read = capture into s_spi_rx */
+static void sx_transfer(size_t total, bool read)
+{
+    /* Trailing NOP clocks are harmless on reads and keep RX DMA word-sized */
+    if (read) {
+        total = (total + 3) & ~(size_t)3;
+    }
 
     spi_transaction_t t = {
         .length    = total * 8,
-        .tx_buffer = tx,
-        .rx_buffer = rx,
+        .tx_buffer = s_spi_tx,
+        .rx_buffer = read ? s_spi_rx : NULL,
     };
-    spi_device_transmit(s_spi, &t);
+    spi_device_polling_transmit(s_spi, &t);
+}
+
+static void sx_cmd(const uint8_t *cmd, size_t cmd_len,
+                   uint8_t *resp, size_t resp_len)
+{
+    size_t total = cmd_len + resp_len;
+    if (total > SX_SCRATCH_SIZE - 3) {
+        ESP_LOGE(TAG, "SPI command too long (%u bytes)", (unsigned)total);
+        return;
+    }
+
+    wait_busy(cmd[0]);
+
+    /* Short commands travel in the transaction itself - no DMA setup */
+    if (total <= 4) {
+        spi_transaction_t t = {
+            .flags  = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA,
+            .length = total * 8,
+        };
+        memcpy(t.tx_data, cmd, cmd_len);
+        spi_device_polling_transmit(s_spi, &t);
+
+        if (resp && resp_len > 0) {
+            memcpy(resp, t.rx_data + cmd_len, resp_len);
+        }
+        return;
+    }
+
+    memcpy(s_spi_tx, cmd, cmd_len);
+    memset(s_spi_tx + cmd_len, 0, resp_len);
+    sx_transfer(total, resp && resp_len > 0);
 
     if (resp && resp_len > 0) {
-        memcpy(resp, rx + cmd_len, resp_len);
+        memcpy(resp, s_spi_rx + cmd_len, resp_len);
     }
+}
 
-    free(tx);
-    free(rx);
+static void sx_write_buffer(uint8_t offset, const uint8_t *data, uint8_t length)
+{
+    wait_busy(CMD_WRITE_BUFFER);
+
+    s_spi_tx[0] = CMD_WRITE_BUFFER;
+    s_spi_tx[1] = offset;
+    memcpy(s_spi_tx + 2, data, length);
+    sx_transfer(2 + (size_t)length, false);
 }
 
-static void sx_write_reg(uint16_t addr, uint8_t value)
+static void sx_read_buffer(uint8_t offset, uint8_t *data, uint8_t length)
 {
-    uint8_t cmd[] = { CMD_WRITE_REGISTER,
-                      (uint8_t)(addr >> 8), (uint8_t)(addr),
-                      value };
-    sx_cmd(cmd, sizeof(cmd), NULL, 0);
+    wait_busy(CMD_READ_BUFFER);
+
+    s_spi_tx[0] = CMD_READ_BUFFER;
+    s_spi_tx[1] = offset;
+    s_spi_tx[2] = 0x00;   /* NOP - status byte */
+    memset(s_spi_tx + 3, 0, length);
+    sx_transfer(3 + (size_t)length, true);
+
+    memcpy(data, s_spi_rx + 3, length);
+}
+
+/* ─── Init table ──────────────────────────────────────────────── */
+
+/* Parameter encodings shared by the init table and set_config.
+ * Integer-only, so the table is built entirely at compile time. */
+#define SX_FRF(hz)          ((uint32_t)(((uint64_t)(hz) << 25) / 32000000ULL))
+#define SX_BW_CODE(hz)      ((hz) == 500000 ? 0x06 : (hz) == 250000 ? 0x05 : 0x04)
+#define SX_LDRO(sf, hz)     ((((1UL << (sf)) * 1000UL) / ((hz) / 1000UL)) >= 16000UL)
+
+/* SX127x-style sync byte to the SX126x register pair (0x12 -> 0x1424) */
+#define SX_SYNC_MSB(sw)     ((uint8_t)(((sw) & 0xF0) | 0x04))
+#define SX_SYNC_LSB(sw)     ((uint8_t)((((sw) & 0x0F) << 4) | 0x04))
+
+/* CALIBRATE_IMAGE band limits for the ISM band containing `hz` */
+#define SX_CAL_IMG_LO(hz)   ((hz) > 900000000 ? 0xE1 : (hz) > 850000000 ? 0xD7 : \
+                             (hz) > 770000000 ? 0xC1 : (hz) > 460000000 ? 0x75 : 0x6B)
+#define SX_CAL_IMG_HI(hz)   ((hz) > 900000000 ? 0xE9 : (hz) > 850000000 ? 0xDB : \
+                             (hz) > 770000000 ? 0xC5 : (hz) > 460000000 ? 0x81 : 0x6F)
+
+/* Settings the table is generated from */
+#define INIT_FREQ_HZ    ((uint32_t)(LORA_FREQUENCY))
+#define INIT_FRF        SX_FRF(INIT_FREQ_HZ)
+#define INIT_BW_HZ      ((uint32_t)(LORA_BANDWIDTH))
+#define INIT_IRQ_MASK   (IRQ_TX_DONE | IRQ_RX_DONE | IRQ_CRC_ERR | IRQ_TIMEOUT | \
+                         IRQ_CAD_DONE | IRQ_CAD_DETECTED | \
+                         (LORA_HOP_SCAN ? IRQ_HEADER_ERR : 0))
+
+_Static_assert(INIT_BW_HZ == 125000 || INIT_BW_HZ == 250000 || INIT_BW_HZ == 500000,
+               "LORA_BANDWIDTH must be 125, 250 or 500 kHz");
+_Static_assert(LORA_CODING_RATE >= 1 && LORA_CODING_RATE <= 4,
+               "LORA_CODING_RATE must be 1-4");
+_Static_assert(LORA_TX_POWER >= -9 && LORA_TX_POWER <= 22,
+               "LORA_TX_POWER must be -9..22 dBm");
+_Static_assert(LORA_HOP_CHANNELS >= 1 && LORA_HOP_CHANNELS <= HOP_MAX_CHANNELS,
+               "LORA_HOP_CHANNELS must be 1..HOP_MAX_CHANNELS");
+/* Retuning within the plan must not need a new image calibration */
+_Static_assert(SX_CAL_IMG_LO(LORA_HOP_FREQ_HZ(0)) == SX_CAL_IMG_LO(INIT_FREQ_HZ) &&
+               SX_CAL_IMG_LO(LORA_HOP_FREQ_HZ(LORA_HOP_CHANNELS - 1)) ==
+               SX_CAL_IMG_LO(INIT_FREQ_HZ),
+               "Channel plan must lie in the band of LORA_FREQUENCY");
+/* One CAD per channel (SF12 worst case) plus the lock-on window must
+ * fit in the long preamble, or a scan can miss a whole frame */
+_Static_assert(LORA_HOP_CHANNELS * (LORA_CAD_SYMBOLS(12) + 1) + LORA_HOP_SYNC_SYMBOLS <=
+               LORA_WAKE_PREAMBLE,
+               "Channel scan is longer than LORA_WAKE_PREAMBLE");
+
+/* Entry header: command length, INIT_WAIT if the chip holds BUSY for
+ * milliseconds afterwards (calibration). Terminated by a zero byte. */
+#define INIT_WAIT       0x80
+
+static const uint8_t s_init_table[] = {
+    /* Standby RC */
+    2, CMD_SET_STANDBY, 0x00,
+    /* DIO2 as RF switch (required by Heltec V3) */
+    2, CMD_SET_DIO2_AS_RF_SW, 0x01,
+    /* DIO3 as TCXO 1.7 V, ~5 ms timeout */
+    5, CMD_SET_DIO3_AS_TCXO, 0x02, 0x00, 0x00, 0x40,
+    /* Calibrate all blocks */
+    INIT_WAIT | 2, CMD_CALIBRATE, 0x7F,
+    /* Packet type = LoRa */
+    2, CMD_SET_PKT_TYPE, 0x01,
+    /* RF frequency */
+    5, CMD_SET_RF_FREQ, (uint8_t)(INIT_FRF >> 24), (uint8_t)(INIT_FRF >> 16),
+                        (uint8_t)(INIT_FRF >> 8),  (uint8_t)(INIT_FRF),
+    /* Calibrate image for the band in use */
+    INIT_WAIT | 3, CMD_CALIBRATE_IMAGE, SX_CAL_IMG_LO(INIT_FREQ_HZ),
+                                        SX_CAL_IMG_HI(INIT_FREQ_HZ),
+    /* PA config: dutyCycle=4, hpMax=7, devSel=0, paLut=1 */
+    5, CMD_SET_PA_CONFIG, 0x04, 0x07, 0x00, 0x01,
+    /* TX params: power in dBm, ramp 200 us */
+    3, CMD_SET_TX_PARAMS, (uint8_t)LORA_TX_POWER, 0x04,
+    /* Modulation: SF, BW, CR, LDRO */
+    5, CMD_SET_MOD_PARAMS, LORA_SPREADING_FACTOR, SX_BW_CODE(INIT_BW_HZ),
+                           LORA_CODING_RATE, SX_LDRO(LORA_SPREADING_FACTOR, INIT_BW_HZ),
+    /* Packet params for the selected profile. Explicit: RX takes the real
+     * length from the header and TX rewrites it per frame. Implicit: both
+     * ends use the fixed frame size. */
+    7, CMD_SET_PKT_PARAMS, (uint8_t)(PKT_RX_PREAMBLE >> 8), (uint8_t)(PKT_RX_PREAMBLE),
+                           PKT_HEADER_TYPE, PKT_RX_LENGTH, 0x01, 0x00,
+#if LORA_RX_DUTY_CYCLE || LORA_HOP_SCAN
+    /* Keep listening past the window once a preamble is detected */
+    2, CMD_STOP_TIMER_ON_PREAMBLE, 0x01,
+#endif
+    /* Sync word, both register bytes in one write */
+    5, CMD_WRITE_REGISTER, (uint8_t)(REG_SYNC_WORD_MSB >> 8), (uint8_t)(REG_SYNC_WORD_MSB),
+                           SX_SYNC_MSB(LORA_SYNC_WORD), SX_SYNC_LSB(LORA_SYNC_WORD),
+    /* Buffer base addresses */
+    3, CMD_SET_BUF_BASE_ADDR, 0x00, 0x00,
+    /* IRQs: TX_DONE | RX_DONE | TIMEOUT -> DIO1 */
+    9, CMD_SET_DIO_IRQ_PARAMS, (uint8_t)(INIT_IRQ_MASK >> 8), (uint8_t)(INIT_IRQ_MASK),
+                               (uint8_t)(INIT_IRQ_MASK >> 8), (uint8_t)(INIT_IRQ_MASK),
+                               0x00, 0x00, 0x00, 0x00,
+    /* Start from a clean IRQ status */
+    3, CMD_CLR_IRQ_STATUS, 0xFF, 0xFF,
+    0,
+};
+
+/* Each queued command gets its own word-aligned slot in s_spi_tx, so
+ * the SPI driver never has to bounce-copy a DMA buffer */
+#define INIT_SLOT_SIZE  12
+
+_Static_assert(LORA_SPI_QUEUE_SIZE * INIT_SLOT_SIZE <= SX_SCRATCH_SIZE,
+               "init burst does not fit the SPI scratch buffer");
+
+/* Marks queued transactions that must wait for BUSY in sx_pre_transfer() */
+#define SX_TRANS_GATED  ((void *)1)
+/* Set by sx_pre_transfer(): BUSY was still high when the command went out */
+#define SX_TRANS_MISSED ((void *)2)
+
+/**
+ * SPI pre-transfer callback. For queued transactions it runs in the SPI
+ * ISR, so it reads the pin through the HAL and only spins for the few
+ * microseconds configuration commands keep BUSY high. Slower commands
+ * are INIT_WAIT entries, waited for from the task.
+ *
+ * The SPI driver cannot skip a transaction from here. One that still
+ * finds BUSY high is marked SX_TRANS_MISSED instead, and sx_replay()
+ * waits from the task and sends it again.
+ */
+static void IRAM_ATTR sx_pre_transfer(spi_transaction_t *t)
+{
+    if (t->user != SX_TRANS_GATED) {
+        return;
+    }
+    for (uint32_t us = 0; gpio_ll_get_level(&GPIO, LORA_PIN_BUSY); us++) {
+        if (us >= LORA_BUSY_SPIN_US) {
+            t->user = SX_TRANS_MISSED;
+            return;
+        }
+        esp_rom_delay_us(1);
+    }
+}
+
+/**
+ * @brief Replay a command table as queued SPI bursts
+ *
+ * Commands are queued back to back without a task round-trip each; the
+ * burst is drained at every INIT_WAIT entry, which is then waited for on
+ * the BUSY edge, and whenever the queue is full. A burst in which
+ * sx_pre_transfer() gave up on BUSY is resent from the first command it
+ * marked, after a wait from the task (the table's commands only set
+ * state, so repeating the ones behind it is harmless).
+ *
+ * @param table Zero-terminated entries (see s_init_table)
+ * @return Number of commands sent, 0 if the SPI driver refused one or
+ *         BUSY stayed high through a resend
+ */
+static uint8_t sx_replay(const uint8_t *table)
+{
+    spi_transaction_t trans[LORA_SPI_QUEUE_SIZE];
+    const uint8_t *entry[LORA_SPI_QUEUE_SIZE];
+    const uint8_t *retried = NULL;
+    spi_transaction_t *done;
+    uint8_t queued = 0;
+    uint8_t commands = 0;
+
+    /* The first command must not start while BUSY is high */
+    wait_busy(BUSY_OP_NONE);
+
+    while (*table != 0) {
+        uint8_t len  = *table & ~INIT_WAIT;
+        bool    slow = (*table & INIT_WAIT) != 0;
+        uint8_t *slot = s_spi_tx + queued * INIT_SLOT_SIZE;
+
+        memcpy(slot, table + 1, len);
+        entry[queued] = table;
+        trans[queued] = (spi_transaction_t) {
+            .length    = (size_t)len * 8,
+            .tx_buffer = slot,
+            .user      = SX_TRANS_GATED,
+        };
+        if (spi_device_queue_trans(s_spi, &trans[queued], portMAX_DELAY) != ESP_OK) {
+            ESP_LOGE(TAG, "Init command 0x%02X not queued", slot[0]);
+            while (queued-- > 0) {
+                spi_device_get_trans_result(s_spi, &done, portMAX_DELAY);
+            }
+            return 0;
+        }
+        queued++;
+        commands++;
+        table += 1 + len;
+
+        if (slow || queued == LORA_SPI_QUEUE_SIZE || *table == 0) {
+            /* Results come back in queue order */
+            uint8_t missed = queued;
+            for (uint8_t i = 0; i < queued; i++) {
+                spi_device_get_trans_result(s_spi, &done, portMAX_DELAY);
+                if (missed == queued && trans[i].user == SX_TRANS_MISSED) {
+                    missed = i;
+                }
+            }
+            if (missed < queued) {
+                if (entry[missed] == retried) {
+                    ESP_LOGE(TAG, "Init command 0x%02X: BUSY stuck high", entry[missed][1]);
+                    return 0;
+                }
+                /* The previous command held BUSY past the ISR spin */
+                if (missed > 0) {
+                    s_last_opcode = entry[missed - 1][1];
+                }
+#if LORA_BUSY_STATS
+                lora_busy_stats_t *st = s_last_opcode == BUSY_OP_NONE ? NULL
+                                      : busy_stats_slot(s_last_opcode);
+                if (st != NULL) {
+                    st->deferred++;
+                }
+#endif
+                wait_busy(BUSY_OP_NONE);
+                retried  = entry[missed];
+                table    = entry[missed];
+                commands -= queued - missed;
+                queued   = 0;
+                continue;
+            }
+            queued = 0;
+            /* BUSY after the burst belongs to its last command */
+            s_last_opcode = slot[0];
+            if (slow) {
+                wait_busy(BUSY_OP_NONE);
+            }
+        }
+    }
+    return commands;
+}
+
+/* Fixed little-endian layout of lora_radio_config_t (NVS blob, signature) */
+#define CONFIG_BLOB_VERSION  1
+#define CONFIG_BLOB_SIZE     13
+
+static void config_pack(const lora_radio_config_t *cfg, uint8_t *blob)
+{
+    blob[0] = CONFIG_BLOB_VERSION;
+    for (uint8_t i = 0; i < 4; i++) {
+        blob[1 + i] = (uint8_t)(cfg->frequency_hz >> (8 * i));
+        blob[5 + i] = (uint8_t)(cfg->bandwidth_hz >> (8 * i));
+    }
+    blob[9]  = cfg->spreading_factor;
+    blob[10] = cfg->coding_rate;
+    blob[11] = (uint8_t)cfg->tx_power_dbm;
+    blob[12] = cfg->sync_word;
+}
+
+static bool config_unpack(const uint8_t *blob, lora_radio_config_t *cfg)
+{
+    if (blob[0] != CONFIG_BLOB_VERSION) {
+        return false;
+    }
+    cfg->frequency_hz = 0;
+    cfg->bandwidth_hz = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        cfg->frequency_hz |= (uint32_t)blob[1 + i] << (8 * i);
+        cfg->bandwidth_hz |= (uint32_t)blob[5 + i] << (8 * i);
+    }
+    cfg->spreading_factor = blob[9];
+    cfg->coding_rate      = blob[10];
+    cfg->tx_power_dbm     = (int8_t)blob[11];
+    cfg->sync_word        = blob[12];
+    return true;
+}
+
+/* CRC of the init table and the running configuration: the radio can
+ * only be trusted after sleep if both match what this boot would load */
+static uint32_t sx_config_signature(void)
+{
+    uint8_t blob[CONFIG_BLOB_SIZE];
+    config_pack(&s_config, blob);
+
+    uint16_t crc = crc16_update(crc16_init(), s_init_table, sizeof(s_init_table));
+    crc = crc16_final(crc16_update(crc, blob, sizeof(blob)));
+    return ((uint32_t)SX_WARM_MAGIC << 16) | crc;
+}
+
+/* Send the settings that differ from s_config; radio must be in standby */
+static void sx_apply_config(const lora_radio_config_t *cfg)
+{
+    if (cfg->frequency_hz != s_config.frequency_hz || s_channel != LORA_CHANNEL_NONE) {
+        uint32_t frf = SX_FRF(cfg->frequency_hz);
+        uint8_t freq[] = { CMD_SET_RF_FREQ,
+                           (uint8_t)(frf >> 24), (uint8_t)(frf >> 16),
+                           (uint8_t)(frf >>  8), (uint8_t)(frf) };
+        sx_cmd(freq, sizeof(freq), NULL, 0);
+
+        uint8_t calimg[] = { CMD_CALIBRATE_IMAGE,
+                             SX_CAL_IMG_LO(cfg->frequency_hz),
+                             SX_CAL_IMG_HI(cfg->frequency_hz) };
+        sx_cmd(calimg, sizeof(calimg), NULL, 0);
+        s_channel = LORA_CHANNEL_NONE;
+    }
+
+    if (cfg->spreading_factor != s_config.spreading_factor ||
+        cfg->bandwidth_hz != s_config.bandwidth_hz ||
+        cfg->coding_rate != s_config.coding_rate) {
+        uint8_t mod[] = { CMD_SET_MOD_PARAMS, cfg->spreading_factor,
+                          SX_BW_CODE(cfg->bandwidth_hz), cfg->coding_rate,
+                          SX_LDRO(cfg->spreading_factor, cfg->bandwidth_hz) };
+        sx_cmd(mod, sizeof(mod), NULL, 0);
+    }
+
+    if (cfg->tx_power_dbm != s_config.tx_power_dbm) {
+        uint8_t txp[] = { CMD_SET_TX_PARAMS, (uint8_t)cfg->tx_power_dbm, 0x04 };
+        sx_cmd(txp, sizeof(txp), NULL, 0);
+    }
+
+    if (cfg->sync_word != s_config.sync_word) {
+        uint8_t sync[] = { CMD_WRITE_REGISTER,
+                           (uint8_t)(REG_SYNC_WORD_MSB >> 8), (uint8_t)(REG_SYNC_WORD_MSB),
+                           SX_SYNC_MSB(cfg->sync_word), SX_SYNC_LSB(cfg->sync_word) };
+        sx_cmd(sync, sizeof(sync), NULL, 0);
+    }
+
+    s_config = *cfg;
+}
+
+/* Radio slept with our configuration and the ESP32 woke from deep sleep
+ * (any other reset may have cut the radio's supply or left it mid-TX) */
+static bool sx_warm_start_valid(void)
+{
+#if LORA_WARM_START
+    return esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_UNDEFINED
+        && s_rtc_config_sig == sx_config_signature();
+#else
+    return false;
+#endif
 }
 
 /* ─── Reset ───────────────────────────────────────────────────── */
@@ -101,10 +701,11 @@ static void sx_write_reg(uint16_t addr, uint8_t value)
 static void lora_reset(void)
 {
     gpio_set_level(LORA_PIN_RST, 0);
-    vTaskDelay(pdMS_TO_TICKS(20));
+    esp_rom_delay_us(SX_RESET_PULSE_US);
     gpio_set_level(LORA_PIN_RST, 1);
-    vTaskDelay(pdMS_TO_TICKS(50));
-    wait_busy();
+
+    s_last_opcode = LORA_BUSY_OP_RESET;
+    wait_busy(BUSY_OP_NONE);
 }
 
 /* ─── IRQ helpers ─────────────────────────────────────────────── */
@@ -124,22 +725,312 @@ static void sx_clear_irq(uint16_t mask)
     sx_cmd(cmd, sizeof(cmd), NULL, 0);
 }
 
+/* ─── DIO1 interrupt ──────────────────────────────────────────── */
+
+static void IRAM_ATTR dio1_isr_handler(void *arg)
+{
+    (void)arg;
+    BaseType_t woken = pdFALSE;
+    TaskHandle_t task = s_irq_task;
+
+    /* During TX the only IRQ routed to DIO1 is TX_DONE */
+    if (s_tx_in_flight) {
+        s_tx_in_flight = false;
+        lora_tx_result_t result = {
+            .status      = LORA_TX_OK,
+            .length      = s_tx_length,
+            .duration_us = (uint32_t)(esp_timer_get_time() - s_tx_start_us),
+        };
+        xQueueSendFromISR(s_tx_done, &result, &woken);
+    } else {
+        s_rx_irq_us = esp_timer_get_time();
+    }
+
+    if (task != NULL) {
+        vTaskNotifyGiveFromISR(task, &woken);
+    }
+    portYIELD_FROM_ISR(woken);
+}
+
+/* ─── Packet params ───────────────────────────────────────────── */
+
+/* Preamble, header type, payload length, CRC on, standard IQ */
+static void sx_set_packet_params(uint16_t preamble, uint8_t length)
+{
+    uint8_t pkt[] = { CMD_SET_PKT_PARAMS,
+                      (uint8_t)(preamble >> 8), (uint8_t)(preamble),
+                      PKT_HEADER_TYPE,
+                      length,
+                      0x01,
+                      0x00 };
+    sx_cmd(pkt, sizeof(pkt), NULL, 0);
+}
+
+/* ─── Channel activity detection ──────────────────────────────── */
+
+/* CAD detection thresholds per SF (BW125, AN1200.48 starting points) */
+static const uint8_t s_cad_det_peak[6] = { 22, 22, 23, 24, 25, 28 };
+#define CAD_DET_MIN              10
+#define CAD_EXIT_CAD_ONLY        0x00   /* Back to STDBY_RC after CAD_DONE */
+#define CAD_EXIT_CAD_RX          0x01   /* RX for cadTimeout after a hit   */
+
+/* SET_CAD_PARAMS cadSymbolNum code: 0 = 1 symbol ... 4 = 16 symbols */
+static uint8_t sx_cad_symbol_code(uint8_t symbols)
+{
+    uint8_t code = 0;
+    while ((1u << code) < symbols && code < 4) {
+        code++;
+    }
+    return code;
+}
+
+bool lora_driver_cad(void)
+{
+    uint8_t sf      = s_config.spreading_factor;
+    uint8_t symbols = LORA_CAD_SYMBOLS(sf);
+
+    /* Standby would abort the frame on air */
+    if (s_tx_in_flight) {
+        ESP_LOGW(TAG, "CAD skipped - TX in progress");
+        return false;
+    }
+    lora_driver_standby();
+
+    /* Sent every time: cheap, and always matches the running SF */
+    uint8_t params[] = { CMD_SET_CAD_PARAMS, sx_cad_symbol_code(symbols),
+                         s_cad_det_peak[sf - 7], CAD_DET_MIN,
+                         CAD_EXIT_CAD_ONLY, 0x00, 0x00, 0x00 };
+    sx_cmd(params, sizeof(params), NULL, 0);
+    sx_clear_irq(0xFFFF);
+
+    uint8_t cad[] = { CMD_SET_CAD };
+    sx_cmd(cad, 1, NULL, 0);
+
+    /* CAD_DONE after the listened symbols plus about one of processing */
+    uint32_t symbol_us = (uint32_t)(((uint64_t)1000000 << sf) / s_config.bandwidth_hz);
+    lora_driver_wait_irq((symbols + 1) * symbol_us / 1000 + 2);
+
+    uint16_t irq = sx_get_irq();
+    sx_clear_irq(0xFFFF);
+    s_lbt.cad_runs++;
+
+    if (!(irq & IRQ_CAD_DONE)) {
+        ESP_LOGW(TAG, "CAD did not complete (IRQ 0x%04X)", irq);
+        lora_driver_standby();
+        return false;
+    }
+    if (irq & IRQ_CAD_DETECTED) {
+        s_lbt.cad_busy++;
+        return true;
+    }
+    return false;
+}
+
+void lora_driver_get_lbt_stats(lora_lbt_stats_t *stats)
+{
+    *stats = s_lbt;
+}
+
+#if LORA_LBT_ENABLED
+/* Hold the frame while CAD hears someone else, backing off a random
+ * 1..2^n slots after the n-th busy CAD. After LORA_LBT_MAX_ATTEMPTS the
+ * frame goes anyway: waiting longer only grows the queue behind it. */
+static void sx_lbt_wait(void)
+{
+    uint8_t busy = 0;
+
+    while (lora_driver_cad()) {
+        if (++busy >= LORA_LBT_MAX_ATTEMPTS) {
+            s_lbt.forced++;
+            ESP_LOGW(TAG, "Channel still busy after %d CADs - sending", busy);
+            return;
+        }
+        if (busy == 1) {
+            s_lbt.deferred++;
+        }
+
+        uint8_t  exp    = busy < LORA_LBT_BACKOFF_MAX_EXP ? busy : LORA_LBT_BACKOFF_MAX_EXP;
+        uint32_t window = 1u << exp;
+        uint32_t ms     = (1 + esp_random() % window) * LORA_LBT_BACKOFF_SLOT_MS;
+        s_lbt.backoff_ms += ms;
+        vTaskDelay(pdMS_TO_TICKS(ms));
+    }
+}
+#endif
+
+/* ─── Channel plan ────────────────────────────────────────────── */
+
+/* Retune within the plan; no image calibration needed (same band) */
+static void sx_tune(uint8_t channel)
+{
+    uint32_t frf = SX_FRF(LORA_HOP_FREQ_HZ(channel));
+    uint8_t freq[] = { CMD_SET_RF_FREQ,
+                       (uint8_t)(frf >> 24), (uint8_t)(frf >> 16),
+                       (uint8_t)(frf >>  8), (uint8_t)(frf) };
+    sx_cmd(freq, sizeof(freq), NULL, 0);
+    s_channel = channel;
+}
+
+bool lora_driver_set_channel(uint8_t channel)
+{
+    if (channel >= LORA_HOP_CHANNELS) {
+        return false;
+    }
+    if (s_tx_in_flight) {
+        ESP_LOGW(TAG, "Channel change refused - TX in progress");
+        return false;
+    }
+    if (channel != s_channel) {
+        lora_driver_standby();
+        sx_tune(channel);
+    }
+    return true;
+}
+
+uint8_t lora_driver_get_channel(void)
+{
+    return s_channel;
+}
+
+void lora_driver_get_hop_stats(lora_hop_stats_t *stats)
+{
+    *stats = s_hop;
+}
+
+#if LORA_HOP_SCAN
+/* Next channel, then one CAD there. On a hit the chip goes straight on
+ * to RX (CAD_RX exit) for LORA_HOP_SYNC_SYMBOLS; finding the preamble in
+ * that time stops the timer and the frame is received. Radio must be in
+ * standby; DIO1 reports CAD_DONE, then RX_DONE or TIMEOUT after a hit. */
+static void sx_scan_step(void)
+{
+    uint8_t  sf        = s_config.spreading_factor;
+    uint32_t symbol_us = (uint32_t)(((uint64_t)1000000 << sf) / s_config.bandwidth_hz);
+    uint32_t timeout   = SX_RXDC_STEPS(LORA_HOP_SYNC_SYMBOLS * symbol_us);
+
+    s_scan_channel = (uint8_t)((s_scan_channel + 1) % LORA_HOP_CHANNELS);
+    sx_tune(s_scan_channel);
+
+    uint8_t params[] = { CMD_SET_CAD_PARAMS, sx_cad_symbol_code(LORA_CAD_SYMBOLS(sf)),
+                         s_cad_det_peak[sf - 7], CAD_DET_MIN, CAD_EXIT_CAD_RX,
+                         (uint8_t)(timeout >> 16), (uint8_t)(timeout >> 8),
+                         (uint8_t)(timeout) };
+    sx_cmd(params, sizeof(params), NULL, 0);
+
+    uint8_t cad[] = { CMD_SET_CAD };
+    sx_cmd(cad, 1, NULL, 0);
+    s_hop.cad_runs++;
+}
+#endif
+
+/* ─── Receive mode ────────────────────────────────────────────── */
+
+void lora_driver_get_rx_duty_cycle(uint32_t *rx_us, uint32_t *sleep_us)
+{
+    airtime_params_t p = {
+        .sf              = s_config.spreading_factor,
+        .bw_hz           = s_config.bandwidth_hz,
+        .cr              = s_config.coding_rate,
+        .preamble        = LORA_WAKE_PREAMBLE,
+        .implicit_header = false,
+        .crc_on          = true,
+    };
+    airtime_rx_duty_cycle(&p, LORA_RXDC_RX_SYMBOLS, SX_RXDC_WAKE_US, rx_us, sleep_us);
+#if !LORA_RX_DUTY_CYCLE
+    *sleep_us = 0;
+#endif
+}
+
+/* Continuous RX, listen/sleep cycles until a preamble is caught, or a
+ * channel scan. Continuous RX keeps listening after RX_DONE; the other
+ * two drop to standby and have to be re-armed. */
+static void sx_start_rx(void)
+{
+#if LORA_LONG_PREAMBLE || LORA_RX_DUTY_CYCLE || LORA_HOP_SCAN
+    /* A TX may have left a different preamble in the packet params */
+    sx_set_packet_params(PKT_RX_PREAMBLE, PKT_RX_LENGTH);
+#endif
+
+#if LORA_HOP_SCAN
+    /* A CAD may be running: retuning needs standby */
+    lora_driver_standby();
+    sx_scan_step();
+    return;
+#endif
+
+#if LORA_RX_DUTY_CYCLE
+    uint32_t rx_us, sleep_us;
+    lora_driver_get_rx_duty_cycle(&rx_us, &sleep_us);
+    if (sleep_us > 0) {
+        uint32_t rx    = SX_RXDC_STEPS(rx_us);
+        uint32_t sleep = SX_RXDC_STEPS(sleep_us);
+        uint8_t rxdc[] = { CMD_SET_RX_DUTY_CYCLE,
+                           (uint8_t)(rx >> 16),    (uint8_t)(rx >> 8),    (uint8_t)(rx),
+                           (uint8_t)(sleep >> 16), (uint8_t)(sleep >> 8), (uint8_t)(sleep) };
+        sx_cmd(rxdc, sizeof(rxdc), NULL, 0);
+
+        /* BUSY is high through every sleep phase, so the next command
+         * has to wake the chip like after SET_SLEEP. That also ends the
+         * cycling: whoever talks to the radio must re-arm RX. */
+        s_asleep = true;
+        return;
+    }
+#endif
+
+    uint8_t rx[] = { CMD_SET_RX, 0xFF, 0xFF, 0xFF };
+    sx_cmd(rx, sizeof(rx), NULL, 0);
+}
+
 /* ─── Public API ──────────────────────────────────────────────── */
 
 bool lora_driver_init(void)
 {
     /* ── GPIO setup ── */
+    /* The output latch is 0 after any reset, deep-sleep wake included:
+     * set it before enabling the output so a warm start does not hold
+     * the chip in reset */
+    gpio_set_level(LORA_PIN_RST, 1);
     gpio_config_t out_conf = {
         .pin_bit_mask = (1ULL << LORA_PIN_RST),
         .mode         = GPIO_MODE_OUTPUT,
     };
     gpio_config(&out_conf);
 
+    /* BUSY edge interrupt stays disabled except inside wait_busy_edge() */
     gpio_config_t in_conf = {
-        .pin_bit_mask = (1ULL << LORA_PIN_BUSY) | (1ULL << LORA_PIN_IRQ),
+        .pin_bit_mask = (1ULL << LORA_PIN_BUSY),
         .mode         = GPIO_MODE_INPUT,
+        .intr_type    = GPIO_INTR_NEGEDGE,
     };
     gpio_config(&in_conf);
+    gpio_intr_disable(LORA_PIN_BUSY);
+
+    /* Completion queue must exist before the DIO1 ISR is attached */
+    if (s_tx_done == NULL) {
+        s_tx_done = xQueueCreate(1, sizeof(lora_tx_result_t));
+        if (s_tx_done == NULL) {
+            ESP_LOGE(TAG, "No memory for TX completion queue");
+            return false;
+        }
+    }
+
+    /* DIO1 goes high on TX_DONE / RX_DONE / TIMEOUT and stays high until
+     * the IRQ is cleared over SPI */
+    gpio_config_t irq_conf = {
+        .pin_bit_mask = (1ULL << LORA_PIN_IRQ),
+        .mode         = GPIO_MODE_INPUT,
+        .intr_type    = GPIO_INTR_POSEDGE,
+    };
+    gpio_config(&irq_conf);
+
+    /* The ISR service may already be installed by another driver */
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "GPIO ISR service failed: %s", esp_err_to_name(err));
+        return false;
+    }
+    gpio_isr_handler_add(LORA_PIN_IRQ, dio1_isr_handler, NULL);
+    gpio_isr_handler_add(LORA_PIN_BUSY, busy_isr_handler, NULL);
 
     /* ── SPI bus ── */
     spi_bus_config_t bus = {
@@ -148,204 +1039,560 @@ bool lora_driver_init(void)
         .sclk_io_num   = LORA_PIN_SCK,
         .quadwp_io_num = -1,
         .quadhd_io_num = -1,
+        .max_transfer_sz = SX_SCRATCH_SIZE,
     };
     spi_bus_initialize(SPI2_HOST, &bus, SPI_DMA_CH_AUTO);
 
+    /* Runtime traffic uses polling transmit: a few bytes to a few
+     * hundred microseconds, shorter than an interrupt round-trip. Only
+     * the init table is queued, gated on BUSY by sx_pre_transfer(). */
     spi_device_interface_config_t dev = {
-        .clock_speed_hz = 4000000,
+        .clock_speed_hz = LORA_SPI_CLOCK_HZ,
         .mode           = 0,
         .spics_io_num   = LORA_PIN_CS,
-        .queue_size     = 4,
+        .queue_size     = LORA_SPI_QUEUE_SIZE,
+        .pre_cb         = sx_pre_transfer,
     };
     spi_bus_add_device(SPI2_HOST, &dev, &s_spi);
 
-    /* ── Hardware reset ── */
-    lora_reset();
+    int64_t boot_start = esp_timer_get_time();
 
-    /* ── Standby RC ── */
-    uint8_t standby[] = { CMD_SET_STANDBY, 0x00 };
-    sx_cmd(standby, 2, NULL, 0);
-
-    /* ── DIO2 as RF switch (required by Heltec V3) ── */
-    uint8_t dio2[] = { CMD_SET_DIO2_AS_RF_SW, 0x01 };
-    sx_cmd(dio2, 2, NULL, 0);
-
-    /* ── DIO3 as TCXO 1.7 V, ~5 ms timeout ── */
-    uint8_t dio3[] = { CMD_SET_DIO3_AS_TCXO, 0x02, 0x00, 0x00, 0x40 };
-    sx_cmd(dio3, 5, NULL, 0);
+    /* A saved configuration replaces the compiled-in defaults */
+    lora_radio_config_t saved;
+    bool have_saved = lora_driver_config_load(&saved);
+    if (have_saved) {
+        s_config = saved;
+    }
+    bool warm = sx_warm_start_valid();
 
-    /* ── Calibrate all blocks ── */
-    uint8_t cal[] = { CMD_CALIBRATE, 0x7F };
-    sx_cmd(cal, 2, NULL, 0);
-    vTaskDelay(pdMS_TO_TICKS(10));
+    /* One use only; lora_driver_sleep() sets it again */
+    s_rtc_config_sig = 0;
 
-    /* ── Packet type = LoRa ── */
-    uint8_t ptype[] = { CMD_SET_PKT_TYPE, 0x01 };
-    sx_cmd(ptype, 2, NULL, 0);
+    if (warm) {
+        /* ── Warm start: configuration and calibration were retained ── */
+        s_asleep = true;
+        sx_clear_irq(0xFFFF);   /* Wakes the chip first */
+        ESP_LOGI(TAG, "Radio warm start %lu us (config retained in sleep)",
+                 (unsigned long)(esp_timer_get_time() - boot_start));
+    } else {
+        /* ── Hardware reset, then the whole configuration as one table ── */
+        lora_reset();
 
-    /* ── Frequency 915 MHz ── */
-    uint32_t frf = (uint32_t)((double)915000000 / 32000000.0 * (1 << 25));
-    uint8_t freq[] = { CMD_SET_RF_FREQ,
-                       (uint8_t)(frf >> 24), (uint8_t)(frf >> 16),
-                       (uint8_t)(frf >>  8), (uint8_t)(frf) };
-    sx_cmd(freq, 5, NULL, 0);
+        uint8_t commands = sx_replay(s_init_table);
+        if (commands == 0) {
+            return false;
+        }
 
-    /* ── Calibrate image for 902-928 MHz ── */
-    uint8_t calimg[] = { CMD_CALIBRATE_IMAGE, 0xE1, 0xE9 };
-    sx_cmd(calimg, 3, NULL, 0);
+        /* The table holds the defaults; send what the saved copy changes */
+        if (have_saved) {
+            lora_radio_config_t defaults = LORA_RADIO_CONFIG_DEFAULT;
+            s_config = defaults;
+            sx_apply_config(&saved);
+        }
+        ESP_LOGI(TAG, "Radio bring-up %lu us (%u commands at %d MHz)",
+                 (unsigned long)(esp_timer_get_time() - boot_start), commands,
+                 LORA_SPI_CLOCK_HZ / 1000000);
+    }
 
-    /* ── PA config: dutyCycle=4, hpMax=7, devSel=0, paLut=1 ── */
-    uint8_t pa[] = { CMD_SET_PA_CONFIG, 0x04, 0x07, 0x00, 0x01 };
-    sx_cmd(pa, 5, NULL, 0);
+    ESP_LOGI(TAG, "SX1262 initialized - %lu.%03lu MHz, SF%u, BW%lu, CR4/%u, %+d dBm, "
+             "sync 0x%02X (%s), %s header, preamble %d",
+             (unsigned long)(s_config.frequency_hz / 1000000),
+             (unsigned long)(s_config.frequency_hz / 1000 % 1000),
+             s_config.spreading_factor, (unsigned long)(s_config.bandwidth_hz / 1000),
+             s_config.coding_rate + 4, s_config.tx_power_dbm, s_config.sync_word,
+             have_saved ? "NVS" : "defaults",
+             PKT_HEADER_TYPE == PKT_HEADER_IMPLICIT ? "implicit" : "explicit",
+             PKT_TX_PREAMBLE);
+#if LORA_HOP_TX || LORA_HOP_SCAN
+    ESP_LOGI(TAG, "Hopping plan: %d channels from %lu.%03lu MHz, %lu kHz apart (%s)",
+             LORA_HOP_CHANNELS, (unsigned long)(LORA_HOP_BASE_HZ / 1000000),
+             (unsigned long)(LORA_HOP_BASE_HZ / 1000 % 1000),
+             (unsigned long)(LORA_HOP_SPACING_HZ / 1000),
+             LORA_HOP_SCAN ? "CAD scan" : "per-frame hops");
+#endif
+#if LORA_RX_DUTY_CYCLE
+    uint32_t rxdc_rx_us, rxdc_sleep_us;
+    lora_driver_get_rx_duty_cycle(&rxdc_rx_us, &rxdc_sleep_us);
+    ESP_LOGI(TAG, "Duty-cycled RX: listen %lu us, sleep %lu us (%d-symbol wake preamble)",
+             (unsigned long)rxdc_rx_us, (unsigned long)rxdc_sleep_us, LORA_WAKE_PREAMBLE);
+#endif
+    ESP_LOGI(TAG, "Airtime %d B frame: standard %lu us, low-airtime %lu us",
+             LORA_IMPLICIT_PACKET_SIZE,
+             (unsigned long)lora_driver_airtime_us(LORA_PROFILE_STANDARD,
+                                                   LORA_IMPLICIT_PACKET_SIZE),
+             (unsigned long)lora_driver_airtime_us(LORA_PROFILE_LOW_AIRTIME,
+                                                   LORA_IMPLICIT_PACKET_SIZE));
+    return true;
+}
 
-    /* ── TX params: +20 dBm, ramp 200 us ── */
-    uint8_t txp[] = { CMD_SET_TX_PARAMS, 0x16, 0x04 };
-    sx_cmd(txp, 3, NULL, 0);
+bool lora_driver_send(const uint8_t *data, uint8_t length)
+{
+    lora_tx_result_t result = { .status = LORA_TX_ERROR };
 
-    /* ── Modulation: SF7, BW125, CR4/5, LDRO off ── */
-    uint8_t mod[] = { CMD_SET_MOD_PARAMS, 0x07, 0x04, 0x01, 0x00 };
-    sx_cmd(mod, 5, NULL, 0);
+    if (!lora_driver_send_async(data, length)) {
+        return false;
+    }
+    lora_driver_tx_wait(&result, portMAX_DELAY);
+    return result.status == LORA_TX_OK;
+}
 
-    /* ── Packet: preamble 8, explicit hdr, payload len, CRC on, std IQ ── */
-    uint8_t pkt[] = { CMD_SET_PKT_PARAMS,
-                      0x00, 0x08,           /* preamble = 8 */
-                      0x00,                 /* explicit header */
-                      LORA_PACKET_SIZE,     /* payload length */
-                      0x01,                 /* CRC on */
-                      0x00 };               /* standard IQ */
-    sx_cmd(pkt, 7, NULL, 0);
-
-    /* ── Sync word 0x1424 (private network) ── */
-    sx_write_reg(REG_SYNC_WORD_MSB,     0x14);
-    sx_write_reg(REG_SYNC_WORD_MSB + 1, 0x24);
-
-    /* ── Buffer base addresses ── */
-    uint8_t buf[] = { CMD_SET_BUF_BASE_ADDR, 0x00, 0x00 };
-    sx_cmd(buf, 3, NULL, 0);
-
-    /* ── IRQs: TX_DONE | RX_DONE | TIMEOUT → DIO1 ── */
-    uint16_t irq = IRQ_TX_DONE | IRQ_RX_DONE | IRQ_TIMEOUT;
-    uint8_t dio_irq[] = { CMD_SET_DIO_IRQ_PARAMS,
-                          (uint8_t)(irq >> 8), (uint8_t)(irq),
-                          (uint8_t)(irq >> 8), (uint8_t)(irq),
-                          0x00, 0x00,
-                          0x00, 0x00 };
-    sx_cmd(dio_irq, 9, NULL, 0);
+bool lora_driver_send_async(const uint8_t *data, uint8_t length)
+{
+    if (lora_driver_tx_pending()) {
+        ESP_LOGE(TAG, "TX already in progress");
+        return false;
+    }
 
-    sx_clear_irq(0xFFFF);
+#if LORA_PROFILE == LORA_PROFILE_LOW_AIRTIME
+    /* The receiver cannot learn any other length without a header */
+    if (length != LORA_IMPLICIT_PACKET_SIZE) {
+        ESP_LOGE(TAG, "Implicit header needs %d-byte frames, got %d",
+                 LORA_IMPLICIT_PACKET_SIZE, length);
+        return false;
+    }
+#endif
 
-    ESP_LOGI(TAG, "SX1262 initialized - 915 MHz, SF7, BW125, +22 dBm");
-    return true;
-}
+#if LORA_LBT_ENABLED
+    sx_lbt_wait();
+#endif
 
-bool lora_driver_send(const uint8_t *data, uint8_t length)
-{
     /* Standby */
     uint8_t stby[] = { CMD_SET_STANDBY, 0x00 };
     sx_cmd(stby, 2, NULL, 0);
 
+#if LORA_PROFILE != LORA_PROFILE_LOW_AIRTIME
     /* Update payload length in packet params */
-    uint8_t pkt[] = { CMD_SET_PKT_PARAMS,
-                      0x00, 0x08, 0x00, length, 0x01, 0x00 };
-    sx_cmd(pkt, 7, NULL, 0);
+    sx_set_packet_params(PKT_TX_PREAMBLE, length);
+#endif
 
     sx_clear_irq(0xFFFF);
 
     /* Write payload into TX buffer at offset 0 */
-    uint8_t *wr = malloc(2 + length);
-    if (!wr) return false;
-    wr[0] = CMD_WRITE_BUFFER;
-    wr[1] = 0x00;
-    memcpy(wr + 2, data, length);
-    sx_cmd(wr, 2 + length, NULL, 0);
-    free(wr);
+    sx_write_buffer(0x00, data, length);
+
+    /* Arm the ISR before SET_TX so TX_DONE cannot be missed */
+    s_tx_length      = length;
+    s_tx_start_us    = esp_timer_get_time();
+    s_tx_deadline_us = s_tx_start_us
+                     + lora_driver_airtime_us(LORA_PROFILE, length)
+                     + (int64_t)LORA_TX_TIMEOUT_MARGIN_MS * 1000;
+    s_tx_in_flight   = true;
 
     /* Start TX (no timeout) */
     uint8_t tx[] = { CMD_SET_TX, 0x00, 0x00, 0x00 };
     sx_cmd(tx, 4, NULL, 0);
 
-    /* Wait for TX_DONE */
-    uint32_t t = 0;
-    while (!(sx_get_irq() & IRQ_TX_DONE)) {
-        vTaskDelay(pdMS_TO_TICKS(1));
-        if (++t > 5000) {
-            ESP_LOGE(TAG, "TX timeout");
-            sx_cmd(stby, 2, NULL, 0);
-            return false;
+    return true;
+}
+
+bool lora_driver_tx_wait(lora_tx_result_t *result, uint32_t timeout_ms)
+{
+    if (!lora_driver_tx_pending()) {
+        return false;
+    }
+
+    /* Never wait past the frame's deadline, even with portMAX_DELAY */
+    int64_t  left_us = s_tx_deadline_us - esp_timer_get_time();
+    uint32_t wait_ms = left_us > 0 ? (uint32_t)((left_us + 999) / 1000) : 0;
+    bool     capped  = timeout_ms < wait_ms;
+    if (capped) {
+        wait_ms = timeout_ms;
+    }
+
+    uint16_t irq = 0;
+    if (xQueueReceive(s_tx_done, result, sx_ticks(wait_ms)) == pdTRUE) {
+        irq = sx_get_irq();
+        if (!(irq & IRQ_TX_DONE)) {
+            result->status = LORA_TX_ERROR;
         }
+    } else {
+        if (capped) {
+            return false;   /* Still on air */
+        }
+
+        /* Deadline passed. TX_DONE may have been missed (e.g. the CPU was
+         * in light sleep), so ask the radio before calling it a timeout. */
+        s_tx_in_flight = false;
+        lora_tx_result_t stale;
+        xQueueReceive(s_tx_done, &stale, 0);   /* ISR may have raced us */
+
+        irq = sx_get_irq();
+        result->status      = (irq & IRQ_TX_DONE) ? LORA_TX_OK : LORA_TX_TIMEOUT;
+        result->length      = s_tx_length;
+        result->duration_us = (uint32_t)(esp_timer_get_time() - s_tx_start_us);
     }
 
     sx_clear_irq(0xFFFF);
+    uint8_t stby[] = { CMD_SET_STANDBY, 0x00 };
     sx_cmd(stby, 2, NULL, 0);
 
-    ESP_LOGI(TAG, "Packet sent (%d bytes)", length);
+    if (result->status == LORA_TX_OK) {
+        ESP_LOGI(TAG, "Packet sent (%d bytes, %lu us on air)", result->length,
+                 (unsigned long)result->duration_us);
+    } else {
+        ESP_LOGE(TAG, "TX %s (%d bytes, IRQ 0x%04X)",
+                 result->status == LORA_TX_TIMEOUT ? "timeout" : "error",
+                 result->length, irq);
+    }
+    return true;
+}
+
+bool lora_driver_tx_pending(void)
+{
+    return s_tx_in_flight || uxQueueMessagesWaiting(s_tx_done) > 0;
+}
+
+bool lora_driver_wait_irq(uint32_t timeout_ms)
+{
+    s_irq_task = xTaskGetCurrentTaskHandle();
+
+    /* The deadline is kept in microseconds: CAD waits are a few ms,
+     * shorter than a tick */
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+
+    /* DIO1 is level-held, so checking the pin closes the race with an
+     * edge that fired before we registered; stale notifications from an
+     * earlier IRQ just cause one more pass round the loop */
+    while (gpio_get_level(LORA_PIN_IRQ) == 0) {
+        if (timeout_ms == portMAX_DELAY) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        int64_t left_us = deadline - esp_timer_get_time();
+        if (left_us <= 0) {
+            return false;
+        }
+        ulTaskNotifyTake(pdTRUE, sx_ticks((uint32_t)((left_us + 999) / 1000)));
+    }
     return true;
 }
 
 bool lora_driver_available(void)
 {
-    return (sx_get_irq() & IRQ_RX_DONE) != 0;
+    if (gpio_get_level(LORA_PIN_IRQ) == 0) {
+        return false;
+    }
+
+    uint16_t irq = sx_get_irq();
+    s_rx_irq_bits = irq;
+#if LORA_HOP_SCAN
+    if (irq & IRQ_CAD_DETECTED) {
+        s_hop.detected++;
+    }
+#endif
+    if (!(irq & IRQ_RX_DONE)) {
+        /* Stray TX_DONE/TIMEOUT would hold DIO1 high - clear it */
+        sx_clear_irq(irq);
+#if LORA_RX_DUTY_CYCLE
+        /* Reading the IRQ woke the chip out of its RX cycling */
+        sx_start_rx();
+#endif
+#if LORA_HOP_SCAN
+        if ((irq & IRQ_CAD_DETECTED) && !(irq & (IRQ_TIMEOUT | IRQ_HEADER_ERR))) {
+            return false;   /* In RX on this channel: RX_DONE or TIMEOUT next */
+        }
+        if (irq & (IRQ_TIMEOUT | IRQ_HEADER_ERR)) {
+            s_hop.missed++;
+            lora_driver_standby();
+        }
+        sx_scan_step();
+#endif
+        return false;
+    }
+    if (irq & IRQ_CRC_ERR) {
+        s_rx_crc_errors++;
+#if FEC_LINK_PARITY_BYTES == 0
+        /* Payload failed the radio CRC: drop it without reading it out,
+         * the app-level checks may be shorter or absent */
+        s_rx_irq_bits = 0;
+        sx_clear_irq(irq);
+#if LORA_HOP_SCAN
+        /* RX_DONE ended the CAD_RX */
+        sx_scan_step();
+#elif LORA_RX_DUTY_CYCLE
+        sx_start_rx();
+#endif
+        return false;
+#endif
+        /* With FEC parity on the link the frame goes up to be corrected */
+    }
+    return true;
+}
+
+uint32_t lora_driver_get_crc_errors(void)
+{
+    return s_rx_crc_errors;
+}
+
+/* Charge one readout to the RX turnaround counters */
+static void rx_timing_record(int64_t armed_us, int64_t done_us)
+{
+    uint32_t dead    = (uint32_t)(armed_us - s_rx_irq_us);
+    uint32_t readout = (uint32_t)(done_us - s_rx_irq_us);
+
+    s_rx_timing.frames++;
+    s_rx_timing.dead_total_us    += dead;
+    s_rx_timing.readout_total_us += readout;
+    if (dead > s_rx_timing.dead_max_us) {
+        s_rx_timing.dead_max_us = dead;
+    }
+    if (readout > s_rx_timing.readout_max_us) {
+        s_rx_timing.readout_max_us = readout;
+    }
 }
 
-uint8_t lora_driver_receive(uint8_t *buffer, uint8_t length)
+uint8_t lora_driver_receive(uint8_t *buffer, uint8_t length, lora_rx_meta_t *meta)
 {
+    /* Hold the bus for the whole readout: the commands go out back to
+     * back with no bus arbitration in between */
+    spi_device_acquire_bus(s_spi, portMAX_DELAY);
+
     /* Get RX buffer status */
     uint8_t cmd[] = { CMD_GET_RX_BUF_STATUS, 0x00 };
     uint8_t resp[2] = {0};
     sx_cmd(cmd, sizeof(cmd), resp, 2);
 
+    /* Packet status: RssiPkt, SnrPkt (signed, 0.25 dB), SignalRssiPkt */
+    uint8_t ps_cmd[] = { CMD_GET_PKT_STATUS, 0x00 };
+    uint8_t ps[3] = {0};
+    sx_cmd(ps_cmd, sizeof(ps_cmd), ps, 3);
+
+    /* Continuous RX is already listening for the next frame; clearing
+     * this frame's bits lets DIO1 report it. Only those bits: 0xFFFF
+     * could swallow a RX_DONE that arrived since. The next payload
+     * cannot reach the buffer before its preamble and header have been
+     * on air for milliseconds, so the read below can safely come after. */
+    sx_clear_irq(s_rx_irq_bits ? s_rx_irq_bits : 0xFFFF);
+    s_rx_irq_bits = 0;
+    uint8_t channel = s_channel;
+#if LORA_HOP_SCAN
+    /* RX_DONE ended the CAD_RX; scan on straight away, for the same
+     * reason the read can wait */
+    sx_scan_step();
+#endif
+#if !LORA_RX_DUTY_CYCLE
+    int64_t armed_us = esp_timer_get_time();
+#endif
+
     uint8_t plen   = resp[0];
     uint8_t offset = resp[1];
     if (plen > length) plen = length;
 
     /* Read payload */
-    uint8_t *rd = calloc(3 + plen, 1);
-    uint8_t *rx = calloc(plen, 1);
-    if (!rd || !rx) { free(rd); free(rx); return 0; }
-
-    rd[0] = CMD_READ_BUFFER;
-    rd[1] = offset;
-    rd[2] = 0x00;   /* NOP */
-    sx_cmd(rd, 3, rx, plen);
-    memcpy(buffer, rx, plen);
-    free(rd);
-    free(rx);
-
-    /* Get RSSI */
-    uint8_t ps_cmd[] = { CMD_GET_PKT_STATUS, 0x00 };
-    uint8_t ps[3] = {0};
-    sx_cmd(ps_cmd, sizeof(ps_cmd), ps, 3);
-    s_last_rssi = -(int)(ps[0] / 2);
+    sx_read_buffer(offset, buffer, plen);
 
-    sx_clear_irq(0xFFFF);
+#if LORA_RX_DUTY_CYCLE
+    /* RX_DONE ended the cycling, and any command after SET_RX_DUTY_CYCLE
+     * would wake the chip out of it again: re-arm only once read out */
+    sx_start_rx();
+    int64_t armed_us = esp_timer_get_time();
+#endif
 
-    /* Back to continuous RX */
-    uint8_t rx_cmd[] = { CMD_SET_RX, 0xFF, 0xFF, 0xFF };
-    sx_cmd(rx_cmd, 4, NULL, 0);
+    spi_device_release_bus(s_spi);
+    rx_timing_record(armed_us, esp_timer_get_time());
 
-    ESP_LOGI(TAG, "Received %d bytes (RSSI %d dBm)", plen, s_last_rssi);
+    lora_rx_meta_t m = {
+        .rssi_dbm        = (int16_t)-(ps[0] / 2),
+        .signal_rssi_dbm = (int16_t)-(ps[2] / 2),
+        .snr_qdb         = (int8_t)ps[1],
+        .timestamp_us    = s_rx_irq_us,
+        .channel         = channel,
+    };
+    if (meta != NULL) {
+        *meta = m;
+    }
+
+    ESP_LOGI(TAG, "Received %d bytes (RSSI %d dBm, SNR %s%d.%02d dB)", plen, m.rssi_dbm,
+             m.snr_qdb < 0 ? "-" : "", abs(m.snr_qdb) / 4, abs(m.snr_qdb) % 4 * 25);
     return plen;
 }
 
-int lora_driver_rssi(void)
+void lora_driver_get_rx_timing(lora_rx_timing_t *timing)
+{
+    *timing = s_rx_timing;
+}
+
+void lora_driver_log_rx_timing(void)
 {
-    return s_last_rssi;
+    const lora_rx_timing_t *t = &s_rx_timing;
+    if (t->frames == 0) {
+        return;
+    }
+    ESP_LOGI(TAG, "RX turnaround over %lu frames: dead avg %lu us max %lu us, "
+             "readout avg %lu us max %lu us", (unsigned long)t->frames,
+             (unsigned long)(t->dead_total_us / t->frames), (unsigned long)t->dead_max_us,
+             (unsigned long)(t->readout_total_us / t->frames),
+             (unsigned long)t->readout_max_us);
 }
 
 void lora_driver_sleep(void)
 {
     uint8_t cmd[] = { CMD_SET_SLEEP, 0x04 };  /* warm start */
     sx_cmd(cmd, 2, NULL, 0);
+    s_asleep = true;
+#if LORA_WARM_START
+    s_rtc_config_sig = sx_config_signature();
+#endif
     ESP_LOGI(TAG, "SX1262 sleeping");
 }
 
 void lora_driver_wake(void)
 {
+    /* Wakes the chip if asleep; the BUSY wait covers its start-up */
     uint8_t stby[] = { CMD_SET_STANDBY, 0x00 };
     sx_cmd(stby, 2, NULL, 0);
-    vTaskDelay(pdMS_TO_TICKS(10));
 
-    uint8_t rx[] = { CMD_SET_RX, 0xFF, 0xFF, 0xFF };
-    sx_cmd(rx, 4, NULL, 0);
+    sx_start_rx();
     ESP_LOGI(TAG, "SX1262 awake, listening...");
 }
+
+void lora_driver_listen(void)
+{
+    sx_clear_irq(0xFFFF);
+
+    sx_start_rx();
+}
+
+void lora_driver_standby(void)
+{
+    uint8_t stby[] = { CMD_SET_STANDBY, 0x00 };
+    sx_cmd(stby, 2, NULL, 0);
+}
+
+bool lora_driver_config_valid(const lora_radio_config_t *cfg)
+{
+    return cfg->frequency_hz >= 150000000 && cfg->frequency_hz <= 960000000 &&
+           (cfg->bandwidth_hz == 125000 || cfg->bandwidth_hz == 250000 ||
+            cfg->bandwidth_hz == 500000) &&
+           cfg->spreading_factor >= 7 && cfg->spreading_factor <= 12 &&
+           cfg->coding_rate >= 1 && cfg->coding_rate <= 4 &&
+           cfg->tx_power_dbm >= -9 && cfg->tx_power_dbm <= 22;
+}
+
+void lora_driver_get_config(lora_radio_config_t *cfg)
+{
+    *cfg = s_config;
+}
+
+bool lora_driver_set_config(const lora_radio_config_t *cfg)
+{
+    if (!lora_driver_config_valid(cfg)) {
+        ESP_LOGE(TAG, "Invalid radio config rejected");
+        return false;
+    }
+    if (s_tx_in_flight) {
+        ESP_LOGW(TAG, "Radio config not applied - TX pending");
+        return false;
+    }
+
+    lora_driver_standby();
+    sx_apply_config(cfg);
+    ESP_LOGI(TAG, "Radio config: %lu Hz, SF%u, BW%lu, CR4/%u, %+d dBm, sync 0x%02X",
+             (unsigned long)cfg->frequency_hz, cfg->spreading_factor,
+             (unsigned long)(cfg->bandwidth_hz / 1000), cfg->coding_rate + 4,
+             cfg->tx_power_dbm, cfg->sync_word);
+    return true;
+}
+
+bool lora_driver_config_load(lora_radio_config_t *cfg)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(LORA_CONFIG_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return false;   /* Namespace not created yet: nothing saved */
+    }
+
+    uint8_t blob[CONFIG_BLOB_SIZE];
+    size_t size = sizeof(blob);
+    esp_err_t err = nvs_get_blob(nvs, LORA_CONFIG_NVS_KEY, blob, &size);
+    nvs_close(nvs);
+
+    lora_radio_config_t loaded;
+    if (err != ESP_OK || size != sizeof(blob) || !config_unpack(blob, &loaded)) {
+        return false;
+    }
+    if (!lora_driver_config_valid(&loaded)) {
+        ESP_LOGW(TAG, "Saved radio config invalid - using defaults");
+        return false;
+    }
+    *cfg = loaded;
+    return true;
+}
+
+bool lora_driver_config_save(const lora_radio_config_t *cfg)
+{
+    if (!lora_driver_config_valid(cfg)) {
+        return false;
+    }
+
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(LORA_CONFIG_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "NVS open failed: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    uint8_t blob[CONFIG_BLOB_SIZE];
+    config_pack(cfg, blob);
+    err = nvs_set_blob(nvs, LORA_CONFIG_NVS_KEY, blob, sizeof(blob));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Radio config not saved: %s", esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+uint32_t lora_driver_airtime_us(uint8_t profile, uint8_t length)
+{
+    bool low = (profile == LORA_PROFILE_LOW_AIRTIME);
+
+    airtime_params_t p = {
+        .sf              = s_config.spreading_factor,
+        .bw_hz           = s_config.bandwidth_hz,
+        .cr              = s_config.coding_rate,
+        .preamble        = low ? LORA_LOW_AIRTIME_PREAMBLE :
+                           LORA_LONG_PREAMBLE ? LORA_WAKE_PREAMBLE : LORA_STANDARD_PREAMBLE,
+        .implicit_header = low,
+        .crc_on          = true,
+    };
+    return airtime_lora_us(&p, length);
+}
+
+uint8_t lora_driver_get_busy_stats(lora_busy_stats_t *stats, uint8_t max)
+{
+#if LORA_BUSY_STATS
+    uint8_t n = s_busy_stats_used < max ? s_busy_stats_used : max;
+    memcpy(stats, s_busy_stats, n * sizeof(lora_busy_stats_t));
+    return n;
+#else
+    (void)stats;
+    (void)max;
+    return 0;
+#endif
+}
+
+void lora_driver_log_busy_stats(void)
+{
+#if LORA_BUSY_STATS
+    for (uint8_t i = 0; i < s_busy_stats_used; i++) {
+        const lora_busy_stats_t *st = &s_busy_stats[i];
+        ESP_LOGI(TAG, "BUSY op 0x%02X: n=%lu avg=%lu us max=%lu us deferred=%lu "
+                 "[<10us %lu | <100us %lu | <1ms %lu | <10ms %lu | >=10ms %lu]",
+                 st->opcode, st->count, st->total_us / st->count, st->max_us,
+                 st->deferred,
+                 st->hist[0], st->hist[1], st->hist[2], st->hist[3], st->hist[4]);
+    }
+#endif
+}
+
+void lora_driver_reset_busy_stats(void)
+{
+#if LORA_BUSY_STATS
+    memset(s_busy_stats, 0, sizeof(s_busy_stats));
+    s_busy_stats_used = 0;
+#endif
+}
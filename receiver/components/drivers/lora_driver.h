@@ -13,58 +13,457 @@
 #define LORA_PIN_IRQ     14    /* DIO1 */
 #define LORA_PIN_BUSY    13
 
+/* SPI clock: the SX1262 is rated to 16 MHz */
+#define LORA_SPI_CLOCK_HZ    16000000
+#define LORA_SPI_QUEUE_SIZE  8     /* Init-table commands queued per burst */
+
 /* LoRa radio settings */
 #define LORA_FREQUENCY       915E6   /* 915 MHz */
 #define LORA_BANDWIDTH       125E3   /* 125 kHz */
 #define LORA_SPREADING_FACTOR  7     /* SF7 - fast, short range  */
 #define LORA_TX_POWER         20     /* dBm - maximum power      */
+#define LORA_CODING_RATE       1     /* 1-4 => CR 4/5 .. 4/8     */
 #define LORA_SYNC_WORD        0x12   /* Private network sync word */
 
+/**
+ * @brief Radio parameters that can change at runtime
+ *
+ * Defaults are the LORA_* settings above; a copy saved in NVS replaces
+ * them at boot. Both nodes must use the same frequency, SF, bandwidth,
+ * coding rate and sync word.
+ */
+typedef struct {
+    uint32_t frequency_hz;      /* 150-960 MHz                        */
+    uint32_t bandwidth_hz;      /* 125000, 250000 or 500000           */
+    uint8_t  spreading_factor;  /* 7-12                               */
+    uint8_t  coding_rate;       /* 1-4 => 4/5 .. 4/8                  */
+    int8_t   tx_power_dbm;      /* -9 .. +22                          */
+    uint8_t  sync_word;         /* SX127x-style byte, 0x12 = private  */
+} lora_radio_config_t;
+
+#define LORA_RADIO_CONFIG_DEFAULT {                 \
+    .frequency_hz     = (uint32_t)LORA_FREQUENCY,   \
+    .bandwidth_hz     = (uint32_t)LORA_BANDWIDTH,   \
+    .spreading_factor = LORA_SPREADING_FACTOR,      \
+    .coding_rate      = LORA_CODING_RATE,           \
+    .tx_power_dbm     = LORA_TX_POWER,              \
+    .sync_word        = LORA_SYNC_WORD,             \
+}
+
+/* NVS location of the saved configuration */
+#define LORA_CONFIG_NVS_NAMESPACE  "lora"
+#define LORA_CONFIG_NVS_KEY        "radio_cfg"
+
 /* Packet size in bytes */
 #define LORA_PACKET_SIZE       9
 
+/* Largest payload the radio accepts (explicit header carries the length) */
+#define LORA_MAX_PACKET_SIZE   255
+
+/* Radio profile - both nodes must be built with the same one */
+#define LORA_PROFILE_STANDARD      0   /* Explicit header, 8-symbol preamble  */
+#define LORA_PROFILE_LOW_AIRTIME   1   /* Implicit header, short preamble     */
+#define LORA_PROFILE               LORA_PROFILE_STANDARD
+
+#define LORA_STANDARD_PREAMBLE     8
+#define LORA_LOW_AIRTIME_PREAMBLE  6   /* Symbols; shorter = less airtime, weaker sync */
+
+/* Duty-cycled receive: the receiver sleeps between short listen windows
+ * (SetRxDutyCycle) and transmitters stretch their preamble so every
+ * frame spans at least one window. Build transmitters with
+ * LORA_LONG_PREAMBLE and the receiver with LORA_RX_DUTY_CYCLE (the mode
+ * flags here may also be set on the compiler command line); the sleep
+ * period is derived from LORA_WAKE_PREAMBLE and the SF in use. Replies
+ * from the receiver keep the standard preamble. */
+#ifndef LORA_LONG_PREAMBLE
+#define LORA_LONG_PREAMBLE         0    /* TX: send LORA_WAKE_PREAMBLE       */
+#endif
+#ifndef LORA_RX_DUTY_CYCLE
+#define LORA_RX_DUTY_CYCLE         0    /* RX: sniff instead of continuous   */
+#endif
+#define LORA_WAKE_PREAMBLE         128  /* Symbols; 131 ms at SF7/125 kHz    */
+#define LORA_RXDC_RX_SYMBOLS       8    /* Listen window per cycle           */
+
+#if (LORA_LONG_PREAMBLE || LORA_RX_DUTY_CYCLE) && LORA_PROFILE != LORA_PROFILE_STANDARD
+#error "Duty-cycled receive needs LORA_PROFILE_STANDARD"
+#endif
+
+/* Frequency hopping over a plan of LORA_HOP_CHANNELS channels spaced
+ * LORA_HOP_SPACING_HZ from LORA_HOP_BASE_HZ. The default is US915
+ * sub-band 2 (903.9-905.3 MHz), the eight 125 kHz uplink channels most
+ * LoRaWAN gateways listen on. With LORA_HOP_TX a transmitter sends each
+ * frame on the next channel of its own pseudo-random sequence (hop.h).
+ * With LORA_HOP_SCAN the receiver runs a CAD on one channel after
+ * another and stays to receive where it hears a preamble. A whole scan
+ * must fit in one preamble, so hopping transmitters also need
+ * LORA_LONG_PREAMBLE. Replies go out on the channel the frame came in on. */
+#ifndef LORA_HOP_TX
+#define LORA_HOP_TX                0    /* TX: next channel every frame      */
+#endif
+#ifndef LORA_HOP_SCAN
+#define LORA_HOP_SCAN              0    /* RX: CAD scan over the plan        */
+#endif
+#define LORA_HOP_BASE_HZ           903900000
+#define LORA_HOP_SPACING_HZ        200000
+#define LORA_HOP_CHANNELS          8
+#define LORA_HOP_SYNC_SYMBOLS      16   /* RX after a CAD hit to lock on     */
+
+#define LORA_HOP_FREQ_HZ(ch)  ((uint32_t)LORA_HOP_BASE_HZ + (uint32_t)(ch) * LORA_HOP_SPACING_HZ)
+
+/* Not on a plan channel: tuned to the configured frequency_hz */
+#define LORA_CHANNEL_NONE          0xFF
+
+#if LORA_HOP_TX && !LORA_LONG_PREAMBLE
+#error "LORA_HOP_TX needs LORA_LONG_PREAMBLE for a scanning receiver to find the frame"
+#endif
+#if LORA_HOP_SCAN && LORA_RX_DUTY_CYCLE
+#error "LORA_HOP_SCAN and LORA_RX_DUTY_CYCLE are alternative receive modes"
+#endif
+
+/* Implicit header: no length on air, every frame is exactly this size
+ * (must match the TX wire format including FEC parity) */
+#define LORA_IMPLICIT_PACKET_SIZE  LORA_PACKET_SIZE
+
+/* Extra TX_DONE wait on top of the frame's time-on-air */
+#define LORA_TX_TIMEOUT_MARGIN_MS  100
+
+/* Outcome of one transmission, posted by the DIO1 ISR */
+typedef enum {
+    LORA_TX_OK = 0,
+    LORA_TX_TIMEOUT,         /* No TX_DONE within airtime + margin     */
+    LORA_TX_ERROR,           /* DIO1 fired but TX_DONE was not the cause */
+} lora_tx_status_t;
+
+typedef struct {
+    lora_tx_status_t status;
+    uint8_t          length;       /* Frame length in bytes          */
+    uint32_t         duration_us;  /* SET_TX to TX_DONE interrupt    */
+} lora_tx_result_t;
+
+/* Radio measurements for one received frame, read with the frame */
+typedef struct {
+    int16_t rssi_dbm;          /* RssiPkt: average over the frame        */
+    int16_t signal_rssi_dbm;   /* SignalRssiPkt: after despreading       */
+    int8_t  snr_qdb;           /* SnrPkt, 0.25 dB units (-30 = -7.5 dB)  */
+    int64_t timestamp_us;      /* esp_timer time of the RX_DONE interrupt */
+    uint8_t channel;           /* Plan channel, or LORA_CHANNEL_NONE     */
+} lora_rx_meta_t;
+
+/**
+ * @brief RX turnaround since boot, all times from the RX_DONE interrupt
+ *
+ * Dead time ends when the radio can report the next frame: its IRQ
+ * cleared in continuous RX, RX re-armed when duty-cycled. Readout ends
+ * when lora_driver_receive() has the frame and its status in memory.
+ */
+typedef struct {
+    uint32_t frames;            /* Frames read out                       */
+    uint32_t dead_total_us;
+    uint32_t dead_max_us;
+    uint32_t readout_total_us;
+    uint32_t readout_max_us;
+} lora_rx_timing_t;
+
+/* Listen-before-talk: channel activity detection (CAD) before every TX,
+ * random binary-exponential backoff while the channel is busy */
+#define LORA_LBT_ENABLED           0
+#define LORA_LBT_MAX_ATTEMPTS      6    /* Busy CADs before sending anyway */
+#define LORA_LBT_BACKOFF_SLOT_MS   25   /* Backoff unit, ~half a SF7 frame */
+#define LORA_LBT_BACKOFF_MAX_EXP   5    /* Window caps at 2^5 slots        */
+
+/* CAD length in symbols: 2 up to SF8, 4 above (Semtech AN1200.48) */
+#define LORA_CAD_SYMBOLS(sf)       ((sf) <= 8 ? 2 : 4)
+
+/**
+ * @brief Channel scan counters since boot (LORA_HOP_SCAN)
+ */
+typedef struct {
+    uint32_t cad_runs;      /* Scan steps, one CAD each                  */
+    uint32_t detected;      /* CADs that heard LoRa activity             */
+    uint32_t missed;        /* Hits that ended without a frame           */
+} lora_hop_stats_t;
+
+/**
+ * @brief Listen-before-talk counters since boot
+ */
+typedef struct {
+    uint32_t cad_runs;      /* CADs performed                            */
+    uint32_t cad_busy;      /* CADs that detected LoRa activity          */
+    uint32_t deferred;      /* Frames held back at least once            */
+    uint32_t forced;        /* Frames sent after LORA_LBT_MAX_ATTEMPTS   */
+    uint32_t backoff_ms;    /* Total time spent backing off              */
+} lora_lbt_stats_t;
+
+/* Deep-sleep wake skips reset and calibration when the radio slept in
+ * warm-start mode with the configuration this firmware would load */
+#define LORA_WARM_START            1
+
+/* BUSY wait: spin this long, then sleep on the BUSY falling edge */
+#define LORA_BUSY_SPIN_US          150
+#define LORA_BUSY_TIMEOUT_MS       1000
+
+/* Per-opcode BUSY timing (costs two esp_timer reads per command) */
+#define LORA_BUSY_STATS            1
+#define LORA_BUSY_STATS_SLOTS      24   /* Distinct opcodes tracked      */
+#define LORA_BUSY_HIST_BUCKETS     5    /* <10us <100us <1ms <10ms >=10ms */
+#define LORA_BUSY_OP_RESET         0x00 /* Pseudo-opcode: hardware reset */
+
+/**
+ * @brief BUSY-wait timing for one opcode
+ *
+ * BUSY time is charged to the command that caused it, i.e. the one
+ * issued before the wait.
+ */
+typedef struct {
+    uint8_t  opcode;
+    uint32_t count;
+    uint32_t total_us;
+    uint32_t max_us;
+    uint32_t deferred;  /* Init commands after it resent: BUSY outlasted the ISR spin */
+    uint32_t hist[LORA_BUSY_HIST_BUCKETS];
+} lora_busy_stats_t;
+
 /**
  * @brief Initialize LoRa module over SPI
+ *
+ * After a deep-sleep wake that followed lora_driver_sleep() with the same
+ * configuration, the radio is only woken; otherwise it is reset and
+ * fully configured.
  * @return true if module responded correctly, false on error
  */
 bool lora_driver_init(void);
 
 /**
- * @brief Transmit a raw byte buffer
+ * @brief Transmit a raw byte buffer and wait for TX_DONE
  * @param data   Buffer to transmit
  * @param length Number of bytes
  * @return true if transmitted successfully
  */
 bool lora_driver_send(const uint8_t *data, uint8_t length);
 
+/**
+ * @brief Start a transmission and return as soon as the radio is on air
+ *
+ * The frame is copied into the radio before returning, so the caller's
+ * buffer is free immediately. Only one frame can be in flight; collect
+ * its result with lora_driver_tx_wait() before the next radio operation.
+ *
+ * @param data   Buffer to transmit
+ * @param length Number of bytes
+ * @return true if TX started, false if a TX is still pending or on error
+ */
+bool lora_driver_send_async(const uint8_t *data, uint8_t length);
+
+/**
+ * @brief Collect the result of the frame started by lora_driver_send_async()
+ *
+ * Blocks on the completion queue fed by the DIO1 ISR. A frame that has
+ * not finished by its airtime + LORA_TX_TIMEOUT_MARGIN_MS is aborted
+ * and reported as LORA_TX_TIMEOUT.
+ *
+ * @param result     Filled with status, length and TX duration
+ * @param timeout_ms Maximum wait (portMAX_DELAY = until the frame ends)
+ * @return true if a result was collected, false if no TX was pending or
+ *         it is still on air after timeout_ms
+ */
+bool lora_driver_tx_wait(lora_tx_result_t *result, uint32_t timeout_ms);
+
+/**
+ * @brief Check whether a frame is in flight or its result is uncollected
+ */
+bool lora_driver_tx_pending(void);
+
+/**
+ * @brief Block the calling task until DIO1 signals a radio IRQ
+ *
+ * The DIO1 ISR notifies whichever task called this last, so only one
+ * task may wait on the radio at a time. Returns immediately if DIO1 is
+ * already high.
+ *
+ * @param timeout_ms Maximum wait, or portMAX_DELAY to wait forever
+ * @return true if DIO1 is asserted, false on timeout
+ */
+bool lora_driver_wait_irq(uint32_t timeout_ms);
+
 /**
  * @brief Check if a packet has been received
+ *
+ * Reads DIO1 first, so no SPI traffic happens while the radio is idle.
+ * Frames that failed the radio's payload CRC are counted
+ * (lora_driver_get_crc_errors()) and dropped here, unless the link
+ * carries FEC parity (FEC_LINK_PARITY_BYTES > 0) that may still repair
+ * them.
+ *
  * @return true if data is available
  */
 bool lora_driver_available(void);
 
+/**
+ * @brief Frames that failed the radio CRC since boot
+ */
+uint32_t lora_driver_get_crc_errors(void);
+
 /**
  * @brief Read received packet into buffer
  * @param buffer  Destination buffer
  * @param length  Max bytes to read
+ * @param meta    Filled with this frame's RSSI, SNR and RX time (may be NULL)
  * @return Number of bytes read
  */
-uint8_t lora_driver_receive(uint8_t *buffer, uint8_t length);
+uint8_t lora_driver_receive(uint8_t *buffer, uint8_t length, lora_rx_meta_t *meta);
 
 /**
- * @brief Get RSSI of last received packet (signal strength)
- * @return RSSI value in dBm
+ * @brief Put LoRa module into warm-start sleep to save power
+ *
+ * The configuration is retained and its signature kept in RTC memory,
+ * so lora_driver_init() after deep sleep can skip reset and calibration.
+ * Any later radio call wakes the module first. Collect a pending TX with
+ * lora_driver_tx_wait() before calling this.
  */
-int lora_driver_rssi(void);
+void lora_driver_sleep(void);
 
 /**
- * @brief Put LoRa module into sleep mode to save power
+ * @brief Wake LoRa module (if asleep) and set to receive mode
+ *
+ * Receive is continuous, or duty-cycled with LORA_RX_DUTY_CYCLE.
  */
-void lora_driver_sleep(void);
+void lora_driver_wake(void);
 
 /**
- * @brief Wake LoRa module from sleep and set to receive mode
+ * @brief Enter RX right away (no wake delay, e.g. after a TX)
+ *
+ * Continuous, or duty-cycled with LORA_RX_DUTY_CYCLE.
  */
-void lora_driver_wake(void);
+void lora_driver_listen(void);
+
+/**
+ * @brief Leave RX/TX and return to standby
+ */
+void lora_driver_standby(void);
+
+/**
+ * @brief Check a configuration against the ranges the driver supports
+ * @param cfg Configuration to check
+ * @return true if lora_driver_set_config() would accept it
+ */
+bool lora_driver_config_valid(const lora_radio_config_t *cfg);
+
+/**
+ * @brief Copy the configuration the radio is running with
+ * @param cfg Destination
+ */
+void lora_driver_get_config(lora_radio_config_t *cfg);
+
+/**
+ * @brief Apply a configuration without re-initializing the radio
+ *
+ * Only the changed settings are sent. A frequency change also reruns
+ * image calibration. The radio is left in standby; call
+ * lora_driver_listen() to resume RX.
+ *
+ * @param cfg New configuration
+ * @return false if invalid or a TX is still pending
+ */
+bool lora_driver_set_config(const lora_radio_config_t *cfg);
+
+/**
+ * @brief Read the configuration saved in NVS
+ * @param cfg Destination (untouched on failure)
+ * @return true if a valid configuration was found
+ */
+bool lora_driver_config_load(lora_radio_config_t *cfg);
+
+/**
+ * @brief Save a configuration to NVS for the next boot
+ * @param cfg Configuration to save (must be valid)
+ * @return true on success
+ */
+bool lora_driver_config_save(const lora_radio_config_t *cfg);
+
+/**
+ * @brief Time-on-air of one frame this node sends with the current modem
+ *        settings (including LORA_LONG_PREAMBLE)
+ * @param profile LORA_PROFILE_STANDARD or LORA_PROFILE_LOW_AIRTIME
+ * @param length  Payload length in bytes
+ * @return Time-on-air in microseconds
+ */
+uint32_t lora_driver_airtime_us(uint8_t profile, uint8_t length);
+
+/**
+ * @brief Copy BUSY-wait statistics, one entry per opcode seen
+ * @param stats Destination array
+ * @param max   Array capacity
+ * @return Number of entries written
+ */
+uint8_t lora_driver_get_busy_stats(lora_busy_stats_t *stats, uint8_t max);
+
+/**
+ * @brief Run one channel activity detection on the current channel/SF
+ *
+ * Leaves the radio in standby. Blocks for LORA_CAD_SYMBOLS symbols plus
+ * processing (about 3 ms at SF7, 160 ms at SF12, BW125).
+ *
+ * @return true if LoRa activity (preamble or symbols) was detected
+ */
+bool lora_driver_cad(void);
+
+/**
+ * @brief Copy the listen-before-talk counters
+ */
+void lora_driver_get_lbt_stats(lora_lbt_stats_t *stats);
+
+/**
+ * @brief Copy the RX turnaround counters
+ */
+void lora_driver_get_rx_timing(lora_rx_timing_t *timing);
+
+/**
+ * @brief Log average and worst RX dead time and readout time
+ */
+void lora_driver_log_rx_timing(void);
+
+/**
+ * @brief Listen and sleep periods of duty-cycled receive
+ *
+ * Derived from LORA_WAKE_PREAMBLE and the current SF/bandwidth. Sleep is
+ * 0 when LORA_RX_DUTY_CYCLE is off or the preamble is too short to sleep.
+ *
+ * @param rx_us    Listen window in microseconds
+ * @param sleep_us Sleep period in microseconds
+ */
+void lora_driver_get_rx_duty_cycle(uint32_t *rx_us, uint32_t *sleep_us);
+
+/**
+ * @brief Tune to a channel of the hopping plan
+ *
+ * Leaves the radio in standby unless it is already on that channel.
+ * Refused while a frame is on air. lora_driver_set_config() with a new
+ * frequency leaves the plan again.
+ *
+ * @param channel 0..LORA_HOP_CHANNELS-1
+ * @return true if tuned
+ */
+bool lora_driver_set_channel(uint8_t channel);
+
+/**
+ * @brief Plan channel the radio is tuned to
+ * @return Channel, or LORA_CHANNEL_NONE
+ */
+uint8_t lora_driver_get_channel(void);
+
+/**
+ * @brief Copy the channel scan counters
+ */
+void lora_driver_get_hop_stats(lora_hop_stats_t *stats);
+
+/**
+ * @brief Log the BUSY-wait distribution of every opcode
+ */
+void lora_driver_log_busy_stats(void);
+
+/**
+ * @brief Clear BUSY-wait statistics
+ */
+void lora_driver_reset_busy_stats(void);
 
 #endif /* LORA_DRIVER_H */
@@ -1,10 +1,209 @@
 #include "lora_service.h"
 #include "lora_driver.h"
+#include "rx_ring.h"
 #include "packet.h"
+#include "fec.h"
+#include "seq_tracker.h"
+#include "arq.h"
+#include "adr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 
 static const char *TAG = "LORA_SERVICE_RX";
 
+#if LORA_PROFILE == LORA_PROFILE_LOW_AIRTIME && ARQ_LINK_ENABLED
+#error "ARQ ACKs are not fixed-size frames; disable ARQ for the low-airtime profile"
+#endif
+#if LORA_PROFILE == LORA_PROFILE_LOW_AIRTIME && ADR_LINK_ENABLED
+#error "ADR commands are not fixed-size frames; disable ADR for the low-airtime profile"
+#endif
+
+/* Events unpacked from the last aggregated frame, handed out one per call */
+static lora_packet_t s_pending[PACKET_AGG_MAX_EVENTS];
+static lora_rx_meta_t s_pending_meta;
+static uint8_t s_pending_count = 0;
+static uint8_t s_pending_next  = 0;
+
+/* Bytes repaired by link FEC since boot */
+static uint32_t s_fec_corrected = 0;
+
+/* Raw frames from radio readout to decode, and the task decoding them */
+static rx_ring_t    s_ring;
+static TaskHandle_t s_decode_task = NULL;
+static uint32_t     s_rx_invalid  = 0;
+
+/* Readout with the ring full still has to clear the IRQ (and re-arm a
+ * duty-cycled RX) */
+static uint8_t s_discard[RX_RING_FRAME_MAX];
+
+/* Readout and replies (ACK/ADR) drive the radio from different tasks */
+static SemaphoreHandle_t s_radio_lock = NULL;
+
+/* Per-node sequence windows, indexed directly by node_id */
+static seq_tracker_t s_links[256];
+
+#if ADR_LINK_ENABLED
+/* Per-node ADR state, and the radio config every node boots with */
+static adr_link_t s_adr[256];
+static lora_radio_config_t s_adr_base;
+static int64_t s_adr_last_rx_us = 0;
+#endif
+
+/* Run the sender's sequence window; false means drop as duplicate */
+static bool lora_service_accept(const lora_packet_t *pkt)
+{
+    /* Legacy and compact frames carry no sequence number */
+    if (!pkt->has_seq) {
+        return true;
+    }
+
+    seq_tracker_t *link = &s_links[pkt->node_id];
+    switch (seq_tracker_update(link, pkt->seq)) {
+    case SEQ_RESULT_DUPLICATE:
+        ESP_LOGW(TAG, "Duplicate seq %u from node 0x%02X dropped",
+                 pkt->seq, pkt->node_id);
+        return false;
+    case SEQ_RESULT_RESET:
+        ESP_LOGW(TAG, "Node 0x%02X restarted at seq %u", pkt->node_id, pkt->seq);
+        return true;
+    default:
+        return true;
+    }
+}
+
+#if ARQ_LINK_ENABLED || ADR_LINK_ENABLED
+/* Send a reply where the node listens: on the channel its frame came in
+ * on when scanning a hopping plan. Then back to RX. */
+static void lora_service_send_reply(const uint8_t *buffer, uint8_t length,
+                                    const lora_rx_meta_t *meta)
+{
+#if LORA_HOP_SCAN
+    lora_driver_set_channel(meta->channel);
+#else
+    (void)meta;
+#endif
+    lora_driver_send(buffer, length);
+    lora_driver_listen();
+}
+#endif
+
+#if ARQ_LINK_ENABLED
+/* ACK the sender's window right away (inside its ACK timeout), then
+ * return to RX. Duplicates are ACKed too: their first ACK was lost. */
+static void lora_service_send_ack(uint8_t node_id, const lora_rx_meta_t *meta)
+{
+    const seq_tracker_t *link = &s_links[node_id];
+    packet_ack_t ack = {
+        .node_id = node_id,
+        .ack_seq = link->highest,
+        .bitmap  = link->window,
+    };
+
+    uint8_t buffer[PACKET_ACK_SIZE + FEC_MAX_PARITY];
+    uint8_t length = packet_ack_encode(&ack, buffer);
+#if FEC_LINK_PARITY_BYTES > 0
+    length = fec_encode(buffer, length, FEC_LINK_PARITY_BYTES);
+#endif
+    lora_service_send_reply(buffer, length, meta);
+}
+#endif
+
+#if ADR_LINK_ENABLED
+/* Encode and send an ADR command, with FEC parity if enabled */
+static void lora_service_send_adr(const packet_adr_t *cmd, const lora_rx_meta_t *meta)
+{
+    uint8_t buffer[PACKET_ADR_SIZE + FEC_MAX_PARITY];
+    uint8_t length = packet_adr_encode(cmd, buffer);
+#if FEC_LINK_PARITY_BYTES > 0
+    length = fec_encode(buffer, length, FEC_LINK_PARITY_BYTES);
+#endif
+    lora_service_send_reply(buffer, length, meta);
+}
+
+/* Switch our own receiver to the SF a node was just told to use */
+static void lora_service_adr_retune(uint8_t sf)
+{
+    lora_radio_config_t cfg;
+    lora_driver_get_config(&cfg);
+    if (cfg.spreading_factor == sf) {
+        return;
+    }
+    cfg.spreading_factor = sf;
+    if (lora_driver_set_config(&cfg)) {
+        ESP_LOGI(TAG, "ADR: receiver now on SF%d", sf);
+    }
+    lora_driver_listen();
+}
+
+/* Back to the boot SF when the node has gone quiet: either it lost our
+ * command and reverted, or it is gone and the next one starts at base */
+static void lora_service_adr_fallback(void)
+{
+    lora_radio_config_t cfg;
+    lora_driver_get_config(&cfg);
+    if (cfg.spreading_factor == s_adr_base.spreading_factor ||
+        esp_timer_get_time() - s_adr_last_rx_us < (int64_t)ADR_FALLBACK_MS * 1000) {
+        return;
+    }
+
+    ESP_LOGW(TAG, "ADR: no frames for %d s, back to SF%d",
+             ADR_FALLBACK_MS / 1000, s_adr_base.spreading_factor);
+    adr_setting_t start = { s_adr_base.spreading_factor, s_adr_base.tx_power_dbm };
+    for (int i = 0; i < 256; i++) {
+        adr_link_init(&s_adr[i], start);
+    }
+    lora_service_adr_retune(s_adr_base.spreading_factor);
+}
+#endif
+
+/* Reply to a valid frame from node_id: an ADR command if one is due,
+ * then the ARQ ACK, then (SF change only) retune our own receiver. The
+ * command goes out first so the node hears it on its current SF. */
+static void lora_service_reply(uint8_t node_id, bool ack, const lora_rx_meta_t *meta)
+{
+    xSemaphoreTake(s_radio_lock, portMAX_DELAY);
+#if ADR_LINK_ENABLED
+    uint8_t retune_sf = 0;
+    adr_link_t *link = &s_adr[node_id];
+    adr_setting_t next;
+
+    s_adr_last_rx_us = esp_timer_get_time();
+    adr_link_observe(link, meta->snr_qdb, meta->rssi_dbm);
+    uint8_t old_sf = link->current.sf;
+    if (adr_link_decide(link, &next)) {
+        packet_adr_t cmd = {
+            .node_id      = node_id,
+            .sf           = next.sf,
+            .tx_power_dbm = next.tx_power_dbm,
+            .margin_db    = (int8_t)adr_link_margin_db(link),
+        };
+        lora_service_send_adr(&cmd, meta);
+        if (ADR_ADAPT_SF && next.sf != old_sf) {
+            retune_sf = next.sf;
+        }
+        ESP_LOGI(TAG, "ADR: node 0x%02X -> SF%d %+d dBm", node_id,
+                 next.sf, next.tx_power_dbm);
+    }
+#endif
+#if ARQ_LINK_ENABLED
+    if (ack) {
+        lora_service_send_ack(node_id, meta);
+    }
+#endif
+    (void)node_id;
+    (void)ack;
+    (void)meta;
+#if ADR_LINK_ENABLED
+    if (retune_sf != 0) {
+        lora_service_adr_retune(retune_sf);
+    }
+#endif
+    xSemaphoreGive(s_radio_lock);
+}
+
 bool lora_service_init(void)
 {
     bool ok = lora_driver_init();
@@ -13,6 +212,32 @@ bool lora_service_init(void)
         return false;
     }
 
+    if (s_radio_lock == NULL) {
+        s_radio_lock = xSemaphoreCreateMutex();
+        if (s_radio_lock == NULL) {
+            ESP_LOGE(TAG, "No memory for radio lock");
+            return false;
+        }
+    }
+    rx_ring_init(&s_ring);
+
+    /* Where radio bring-up spent its time waiting on BUSY */
+    lora_driver_log_busy_stats();
+
+    for (int i = 0; i < 256; i++) {
+        seq_tracker_init(&s_links[i]);
+    }
+
+#if ADR_LINK_ENABLED
+    /* Every node starts on the configuration we boot with */
+    lora_driver_get_config(&s_adr_base);
+    adr_setting_t start = { s_adr_base.spreading_factor, s_adr_base.tx_power_dbm };
+    for (int i = 0; i < 256; i++) {
+        adr_link_init(&s_adr[i], start);
+    }
+    s_adr_last_rx_us = esp_timer_get_time();
+#endif
+
     /* Set to continuous receive mode */
     lora_driver_wake();
 
@@ -20,37 +245,194 @@ bool lora_service_init(void)
     return true;
 }
 
-bool lora_service_receive_packet(lora_packet_t *pkt)
+bool lora_service_wait(uint32_t timeout_ms)
 {
-    if (!lora_driver_available()) {
-        return false;
+    if (lora_driver_wait_irq(timeout_ms)) {
+        return true;
+    }
+#if ADR_LINK_ENABLED && ADR_ADAPT_SF
+    xSemaphoreTake(s_radio_lock, portMAX_DELAY);
+    lora_service_adr_fallback();
+    xSemaphoreGive(s_radio_lock);
+#endif
+    return false;
+}
+
+uint8_t lora_service_read_frames(void)
+{
+    uint8_t frames = 0;
+
+    xSemaphoreTake(s_radio_lock, portMAX_DELAY);
+    while (lora_driver_available()) {
+        /* Read straight into the ring slot the decoder will use */
+        rx_frame_t *slot = rx_ring_claim(&s_ring);
+        if (slot == NULL) {
+            lora_driver_receive(s_discard, sizeof(s_discard), NULL);
+            ESP_LOGW(TAG, "RX ring full, frame dropped (%lu so far)",
+                     (unsigned long)s_ring.overflow);
+            continue;
+        }
+        slot->length = lora_driver_receive(slot->data, sizeof(slot->data), &slot->meta);
+        rx_ring_publish(&s_ring);
+        frames++;
     }
+    xSemaphoreGive(s_radio_lock);
 
-    uint8_t buffer[LORA_PACKET_SIZE];
-    uint8_t received = lora_driver_receive(buffer, LORA_PACKET_SIZE);
+    TaskHandle_t decoder = s_decode_task;
+    if (frames > 0 && decoder != NULL) {
+        xTaskNotifyGive(decoder);
+    }
+    return frames;
+}
 
-    if (received != LORA_PACKET_SIZE) {
-        ESP_LOGW(TAG, "Unexpected packet size: %d bytes", received);
+bool lora_service_wait_frame(uint32_t timeout_ms)
+{
+    /* Registered before checking, so a frame published in between still
+     * leaves a notification behind */
+    s_decode_task = xTaskGetCurrentTaskHandle();
+
+    if (s_pending_next < s_pending_count || rx_ring_count(&s_ring) > 0) {
+        return true;
+    }
+    ulTaskNotifyTake(pdTRUE, timeout_ms == portMAX_DELAY ? portMAX_DELAY
+                                                         : pdMS_TO_TICKS(timeout_ms));
+    return rx_ring_count(&s_ring) > 0;
+}
+
+/* FEC, format detection, CRC and the sequence window for one raw frame.
+ * Replies to the sender; false if nothing is left to hand out. */
+static bool lora_service_decode(uint8_t *buffer, uint8_t received,
+                                lora_packet_t *pkt, const lora_rx_meta_t *meta)
+{
+#if FEC_LINK_PARITY_BYTES > 0
+    /* Repair byte errors before any CRC check instead of dropping */
+    int fixed = fec_decode(buffer, received, FEC_LINK_PARITY_BYTES);
+    if (fixed < 0) {
+        ESP_LOGE(TAG, "FEC could not repair frame - packet corrupted");
+        s_rx_invalid++;
         return false;
     }
+    if (fixed > 0) {
+        s_fec_corrected += fixed;
+        ESP_LOGW(TAG, "FEC corrected %d byte(s)", fixed);
+    }
+    received -= FEC_LINK_PARITY_BYTES;
+#endif
+
+    switch (packet_detect_format(buffer, received)) {
+    case PACKET_FORMAT_AGGREGATE: {
+        uint8_t n = packet_aggregate_decode(buffer, received,
+                                            s_pending, PACKET_AGG_MAX_EVENTS);
+        if (n == 0) {
+            ESP_LOGE(TAG, "Aggregated frame invalid - packet corrupted");
+            s_rx_invalid++;
+            return false;
+        }
+
+        ESP_LOGI(TAG, "Aggregated frame - node:0x%02X events:%d rssi:%d dBm",
+                 s_pending[0].node_id, n, meta->rssi_dbm);
+
+        /* Keep only events the sequence window has not seen yet */
+        uint8_t kept = 0;
+        for (uint8_t i = 0; i < n; i++) {
+            if (lora_service_accept(&s_pending[i])) {
+                s_pending[kept++] = s_pending[i];
+            }
+        }
+
+        lora_service_reply(s_pending[0].node_id, true, meta);
+        if (kept == 0) {
+            return false;
+        }
+
+        /* Every event of the frame shares its radio measurements */
+        s_pending_meta  = *meta;
+        s_pending_count = kept;
+        s_pending_next  = 1;
+        *pkt = s_pending[0];
+        return true;
+    }
 
-    /* Deserialize bytes into struct */
-    packet_deserialize(buffer, pkt);
+    case PACKET_FORMAT_LEGACY:
+    case PACKET_FORMAT_V2:
+    case PACKET_FORMAT_COMPACT:
+        /* Validate CRC on the raw bytes, then deserialize into struct */
+        if (!packet_decode_any(buffer, received, pkt)) {
+            ESP_LOGE(TAG, "CRC validation failed - packet corrupted");
+            s_rx_invalid++;
+            return false;
+        }
+        bool accepted = lora_service_accept(pkt);
+        lora_service_reply(pkt->node_id, pkt->has_seq, meta);
+        if (!accepted) {
+            return false;
+        }
+        break;
 
-    /* Validate CRC */
-    if (!packet_validate(pkt)) {
-        ESP_LOGE(TAG, "CRC validation failed - packet corrupted");
+    default:
+        ESP_LOGW(TAG, "Unknown frame format: %d bytes", received);
+        s_rx_invalid++;
         return false;
     }
 
     ESP_LOGI(TAG, "Valid packet - node:0x%02X event:0x%02X batt:%d%% rssi:%d dBm",
              pkt->node_id, pkt->event_type,
-             pkt->battery_level, lora_driver_rssi());
+             pkt->battery_level, meta->rssi_dbm);
 
     return true;
 }
 
-int lora_service_get_rssi(void)
+bool lora_service_receive_packet(lora_packet_t *pkt, lora_rx_meta_t *meta)
+{
+    if (s_pending_next < s_pending_count) {
+        *pkt  = s_pending[s_pending_next++];
+        *meta = s_pending_meta;
+        return true;
+    }
+
+    rx_frame_t *frame = rx_ring_peek(&s_ring);
+    if (frame == NULL) {
+        return false;
+    }
+
+    /* Decoded in place; the slot goes back to readout afterwards */
+    *meta = frame->meta;
+    bool ok = lora_service_decode(frame->data, frame->length, pkt, meta);
+    rx_ring_release(&s_ring);
+    return ok;
+}
+
+void lora_service_get_rx_stats(lora_rx_stats_t *stats)
+{
+    stats->frames    = s_ring.published;
+    stats->overflow  = s_ring.overflow;
+    stats->invalid   = s_rx_invalid;
+    stats->radio_crc = lora_driver_get_crc_errors();
+    stats->peak      = s_ring.peak;
+    stats->waiting   = rx_ring_count(&s_ring);
+}
+
+uint32_t lora_service_get_fec_corrected(void)
 {
-    return lora_driver_rssi();
-}
\ No newline at end of file
+    return s_fec_corrected;
+}
+
+bool lora_service_get_link_stats(uint8_t node_id, seq_tracker_t *stats)
+{
+    if (!s_links[node_id].active) {
+        return false;
+    }
+    *stats = s_links[node_id];
+    return true;
+}
+
+bool lora_service_set_radio_config(const lora_radio_config_t *cfg, bool persist)
+{
+    xSemaphoreTake(s_radio_lock, portMAX_DELAY);
+    bool ok = lora_driver_set_config(cfg);
+
+    /* set_config leaves the radio in standby; keep listening either way */
+    lora_driver_listen();
+    xSemaphoreGive(s_radio_lock);
+    return ok && (!persist || lora_driver_config_save(cfg));
+}
@@ -4,6 +4,29 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "packet.h"
+#include "lora_driver.h"
+#include "seq_tracker.h"
+
+/*
+ * Receive runs as two stages in separate tasks. Readout:
+ * lora_service_wait() then lora_service_read_frames() copy raw frames
+ * from the radio into a lock-free ring (rx_ring.h). Decode:
+ * lora_service_wait_frame() then lora_service_receive_packet() validate
+ * them, reply to the sender and hand out packets. A burst is absorbed by
+ * the ring instead of waiting on decode.
+ */
+
+/**
+ * @brief Receive path counters since boot
+ */
+typedef struct {
+    uint32_t frames;        /* Read out of the radio into the ring       */
+    uint32_t overflow;      /* Dropped at readout: ring full             */
+    uint32_t invalid;       /* Failed FEC, CRC or format checks          */
+    uint32_t radio_crc;     /* Bad radio payload CRC (dropped if no FEC) */
+    uint32_t peak;          /* Most frames waiting for decode at once    */
+    uint32_t waiting;       /* Frames waiting right now                  */
+} lora_rx_stats_t;
 
 /**
  * @brief Initialize LoRa service in continuous RX mode
@@ -12,16 +35,75 @@
 bool lora_service_init(void);
 
 /**
- * @brief Check for incoming packet and deserialize it
+ * @brief Readout stage: block until the radio raises DIO1
+ *
+ * With ADR, a timeout also checks whether the receiver should fall back
+ * to its boot SF, so callers should use a finite timeout.
+ *
+ * @param timeout_ms Maximum wait, or portMAX_DELAY to wait forever
+ * @return true if lora_service_read_frames() should be called
+ */
+bool lora_service_wait(uint32_t timeout_ms);
+
+/**
+ * @brief Readout stage: move every received frame into the RX ring
+ *
+ * Frames go straight from the radio buffer into a ring slot with their
+ * lora_rx_meta_t; with the ring full they are read out and dropped
+ * (counted as overflow). Wakes the decode stage.
+ *
+ * @return Frames added to the ring
+ */
+uint8_t lora_service_read_frames(void);
+
+/**
+ * @brief Decode stage: block until raw frames or unpacked events wait
+ * @param timeout_ms Maximum wait, or portMAX_DELAY to wait forever
+ * @return true if lora_service_receive_packet() should be called
+ */
+bool lora_service_wait_frame(uint32_t timeout_ms);
+
+/**
+ * @brief Decode stage: validate the oldest frame in the ring
+ *
+ * Aggregated frames are unpacked and their events returned one per call.
+ * Duplicates (by per-node sequence number) are dropped. ACK and ADR
+ * replies go out from here, serialized with readout.
+ *
  * @param pkt  Destination packet
- * @return true if valid packet received and CRC passed
+ * @param meta RSSI, SNR and RX time of the frame pkt arrived in (events
+ *             from one aggregated frame share it)
+ * @return true if valid packet received and CRC passed; false for an
+ *         empty ring, a duplicate or a corrupted frame (see invalid in
+ *         lora_service_get_rx_stats())
+ */
+bool lora_service_receive_packet(lora_packet_t *pkt, lora_rx_meta_t *meta);
+
+/**
+ * @brief Copy the receive path counters
+ */
+void lora_service_get_rx_stats(lora_rx_stats_t *stats);
+
+/**
+ * @brief Get number of bytes repaired by link FEC since boot
+ * @return Corrected byte count (always 0 when FEC is off)
+ */
+uint32_t lora_service_get_fec_corrected(void);
+
+/**
+ * @brief Get sequence/loss counters for one transmitter
+ * @param node_id Transmitter node ID
+ * @param stats   Destination copy of the node's tracker
+ * @return false if no sequenced frame from this node has been seen
  */
-bool lora_service_receive_packet(lora_packet_t *pkt);
+bool lora_service_get_link_stats(uint8_t node_id, seq_tracker_t *stats);
 
 /**
- * @brief Get RSSI of last received packet
- * @return RSSI in dBm
+ * @brief Retune the radio at runtime, optionally keeping it across reboots
+ * @param cfg     New configuration (see lora_radio_config_t)
+ * @param persist Also save it to NVS so the next boot loads it
+ * @return false if rejected by the driver or the NVS write failed
  */
-int lora_service_get_rssi(void);
+bool lora_service_set_radio_config(const lora_radio_config_t *cfg, bool persist);
 
 #endif /* LORA_SERVICE_H */
\ No newline at end of file
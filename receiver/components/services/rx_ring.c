@@ -0,0 +1,64 @@
+#include "rx_ring.h"
+#include <stddef.h>
+
+/* Indices run freely and wrap at 2^32; head - tail is the fill level */
+#define RX_RING_SLOT(i)  ((i) & (RX_RING_SLOTS - 1))
+
+void rx_ring_init(rx_ring_t *r)
+{
+    atomic_store_explicit(&r->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&r->tail, 0, memory_order_relaxed);
+    r->published = 0;
+    r->overflow  = 0;
+    r->peak      = 0;
+}
+
+rx_frame_t *rx_ring_claim(rx_ring_t *r)
+{
+    unsigned head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    /* Acquire: the consumer is done with the slot before we reuse it */
+    unsigned tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+
+    if (head - tail >= RX_RING_SLOTS) {
+        r->overflow++;
+        return NULL;
+    }
+    return &r->slots[RX_RING_SLOT(head)];
+}
+
+void rx_ring_publish(rx_ring_t *r)
+{
+    unsigned head = atomic_load_explicit(&r->head, memory_order_relaxed) + 1;
+    /* Release: the frame's bytes are visible before the new head */
+    atomic_store_explicit(&r->head, head, memory_order_release);
+
+    r->published++;
+    unsigned fill = head - atomic_load_explicit(&r->tail, memory_order_relaxed);
+    if (fill > r->peak) {
+        r->peak = fill;
+    }
+}
+
+rx_frame_t *rx_ring_peek(rx_ring_t *r)
+{
+    unsigned tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&r->head, memory_order_acquire);
+
+    if (head == tail) {
+        return NULL;
+    }
+    return &r->slots[RX_RING_SLOT(tail)];
+}
+
+void rx_ring_release(rx_ring_t *r)
+{
+    unsigned tail = atomic_load_explicit(&r->tail, memory_order_relaxed) + 1;
+    atomic_store_explicit(&r->tail, tail, memory_order_release);
+}
+
+uint32_t rx_ring_count(rx_ring_t *r)
+{
+    unsigned tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    unsigned head = atomic_load_explicit(&r->head, memory_order_acquire);
+    return head - tail;
+}
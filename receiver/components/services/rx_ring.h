@@ -0,0 +1,79 @@
+#ifndef RX_RING_H
+#define RX_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "packet.h"
+#include "lora_driver.h"
+
+/* Raw frames waiting for decode; a power of two */
+#define RX_RING_SLOTS       16
+#define RX_RING_FRAME_MAX   PACKET_MAX_FRAME_SIZE
+
+_Static_assert((RX_RING_SLOTS & (RX_RING_SLOTS - 1)) == 0,
+               "RX_RING_SLOTS must be a power of two");
+
+/**
+ * @brief One frame as read out of the radio
+ */
+typedef struct {
+    lora_rx_meta_t meta;
+    uint8_t        length;
+    uint8_t        data[RX_RING_FRAME_MAX];
+} rx_frame_t;
+
+/**
+ * @brief Lock-free single-producer / single-consumer ring of raw frames
+ *
+ * The producer (radio readout) writes straight into a claimed slot and
+ * publishes it; the consumer (decode) reads the slot in place and
+ * releases it. head is only written by the producer, tail only by the
+ * consumer, so neither side blocks the other and no frame is copied.
+ */
+typedef struct {
+    rx_frame_t   slots[RX_RING_SLOTS];
+    atomic_uint  head;          /* Next slot to fill (producer)        */
+    atomic_uint  tail;          /* Next slot to decode (consumer)      */
+    uint32_t     published;     /* Frames handed to the consumer       */
+    uint32_t     overflow;      /* Frames dropped: ring full           */
+    uint32_t     peak;          /* Most frames waiting at once         */
+} rx_ring_t;
+
+/**
+ * @brief Empty the ring and clear its counters (no other user may run)
+ */
+void rx_ring_init(rx_ring_t *r);
+
+/**
+ * @brief Producer: next free slot to read a frame into
+ * @return Slot, or NULL when full (counted as overflow)
+ */
+rx_frame_t *rx_ring_claim(rx_ring_t *r);
+
+/**
+ * @brief Producer: hand the claimed slot to the consumer
+ */
+void rx_ring_publish(rx_ring_t *r);
+
+/**
+ * @brief Consumer: oldest published frame, left in the ring
+ *
+ * The consumer owns the slot until rx_ring_release() and may modify it
+ * in place (e.g. FEC repair).
+ *
+ * @return Frame, or NULL when empty
+ */
+rx_frame_t *rx_ring_peek(rx_ring_t *r);
+
+/**
+ * @brief Consumer: give the peeked slot back to the producer
+ */
+void rx_ring_release(rx_ring_t *r);
+
+/**
+ * @brief Frames waiting for the consumer (a snapshot from either side)
+ */
+uint32_t rx_ring_count(rx_ring_t *r);
+
+#endif /* RX_RING_H */
@@ -1,8 +1,11 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
 
 #include "lora_driver.h"
 #include "lora_service.h"
@@ -12,39 +15,80 @@
 
 static const char *TAG = "APP_RX";
 
-/* RX queue - holds received packets */
+/* RX queue - holds received packets with their radio measurements */
 static QueueHandle_t s_queue_rx = NULL;
 
+typedef struct {
+    lora_packet_t  pkt;
+    lora_rx_meta_t meta;
+} rx_item_t;
+
+/* Longest lora_rx_task sleep between DIO1 interrupts */
+#define LORA_RX_WAIT_MS  1000
+
 /* Counters */
-static uint32_t s_rx_count    = 0;
-static uint32_t s_error_count = 0;
+static uint32_t s_rx_count      = 0;
+static uint32_t s_error_count   = 0;
+static uint32_t s_display_drops = 0;
 
-/* ─── Task: Receive LoRa packets ──────────────────────────────── */
+/* ─── Task: Read frames out of the radio ──────────────────────── */
 
 static void lora_rx_task(void *arg)
 {
-    lora_packet_t pkt;
-
     ESP_LOGI(TAG, "lora_rx_task started");
 
     while (1) {
-        if (lora_service_receive_packet(&pkt)) {
+        /* Sleep until DIO1 fires - no SPI polling while the air is quiet */
+        if (lora_service_wait(LORA_RX_WAIT_MS)) {
+            lora_service_read_frames();
+        }
+    }
+}
+
+/* ─── Task: Decode and validate received frames ───────────────── */
+
+static void rx_decode_task(void *arg)
+{
+    rx_item_t item;
+    uint32_t overflow_seen = 0;
+
+    ESP_LOGI(TAG, "rx_decode_task started");
+
+    while (1) {
+        if (!lora_service_wait_frame(LORA_RX_WAIT_MS)) {
+            continue;
+        }
+
+        lora_rx_stats_t before, after;
+        lora_service_get_rx_stats(&before);
+        bool valid = lora_service_receive_packet(&item.pkt, &item.meta);
+        lora_service_get_rx_stats(&after);
+
+        if (valid) {
 
             s_rx_count++;
+            if (s_rx_count % 100 == 0) {
+                lora_driver_log_rx_timing();
+            }
 
-            /* Push valid packet to display queue */
-            if (xQueueSend(s_queue_rx, &pkt, pdMS_TO_TICKS(100)) != pdTRUE) {
-                ESP_LOGW(TAG, "RX queue full, dropping packet");
+            /* The display only shows the latest packet; never hold up decode */
+            if (xQueueSend(s_queue_rx, &item, 0) != pdTRUE) {
+                s_display_drops++;
             }
 
-        } else if (lora_driver_available()) {
-            /* Packet available but CRC failed */
+        } else if (after.invalid != before.invalid) {
+            /* Frame arrived but FEC/CRC failed */
             s_error_count++;
             display_service_show_crc_error(s_error_count);
             ESP_LOGE(TAG, "CRC error #%lu", s_error_count);
         }
-
-        vTaskDelay(pdMS_TO_TICKS(10));
+        if (after.overflow != overflow_seen) {
+            overflow_seen = after.overflow;
+            ESP_LOGW(TAG, "RX ring overflow: %lu of %lu frames dropped (peak %lu waiting)",
+                     (unsigned long)after.overflow,
+                     (unsigned long)(after.frames + after.overflow),
+                     (unsigned long)after.peak);
+        }
     }
 }
 
@@ -52,20 +96,34 @@ static void lora_rx_task(void *arg)
 
 static void display_task(void *arg)
 {
-    lora_packet_t pkt;
+    rx_item_t item;
+    const lora_packet_t *pkt = &item.pkt;
 
     ESP_LOGI(TAG, "display_task started");
 
     while (1) {
-        if (xQueueReceive(s_queue_rx, &pkt, pdMS_TO_TICKS(500)) == pdTRUE) {
+        if (xQueueReceive(s_queue_rx, &item, pdMS_TO_TICKS(500)) == pdTRUE) {
 
-            int rssi = lora_service_get_rssi();
+            /* Measurements of this packet's frame, not the latest one */
+            const lora_rx_meta_t *meta = &item.meta;
 
             /* Update OLED with packet info */
-            display_service_show_rx(&pkt, s_rx_count, rssi);
-
-            ESP_LOGI(TAG, "Displayed packet #%lu - node:0x%02X event:0x%02X rssi:%d",
-                     s_rx_count, pkt.node_id, pkt.event_type, rssi);
+            display_service_show_rx(pkt, s_rx_count, meta->rssi_dbm);
+
+            ESP_LOGI(TAG, "Displayed packet #%lu (%lu skipped) - node:0x%02X event:0x%02X "
+                     "rssi:%d signal:%d snr:%s%d.%02d age:%lu ms",
+                     s_rx_count, s_display_drops, pkt->node_id, pkt->event_type, meta->rssi_dbm,
+                     meta->signal_rssi_dbm, meta->snr_qdb < 0 ? "-" : "",
+                     abs(meta->snr_qdb) / 4, abs(meta->snr_qdb) % 4 * 25,
+                     (unsigned long)((esp_timer_get_time() - meta->timestamp_us) / 1000));
+
+            seq_tracker_t link;
+            if (lora_service_get_link_stats(pkt->node_id, &link)) {
+                uint32_t loss = seq_tracker_loss_permille(&link);
+                ESP_LOGI(TAG, "Link node:0x%02X loss:%lu.%lu%% lost:%lu dup:%lu reorder:%lu",
+                         pkt->node_id, loss / 10, loss % 10,
+                         link.lost, link.duplicates, link.reordered);
+            }
 
         } else {
             /* No packet received - show listening screen */
@@ -85,6 +143,14 @@ void app_main(void)
     display_service_show_boot();
     vTaskDelay(pdMS_TO_TICKS(2000));
 
+    /* NVS holds the saved radio configuration */
+    esp_err_t nvs_err = nvs_flash_init();
+    if (nvs_err == ESP_ERR_NVS_NO_FREE_PAGES || nvs_err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_LOGW(TAG, "NVS partition reformatted");
+        nvs_flash_erase();
+        nvs_flash_init();
+    }
+
     /* Initialize LoRa in RX mode */
     if (!lora_service_init()) {
         ESP_LOGE(TAG, "Failed to initialize LoRa - halting");
@@ -94,14 +160,15 @@ void app_main(void)
     }
 
     /* Create RX queue */
-    s_queue_rx = xQueueCreate(10, sizeof(lora_packet_t));
+    s_queue_rx = xQueueCreate(10, sizeof(rx_item_t));
 
     /* Show listening screen */
     display_service_show_listening();
 
-    /* Create FreeRTOS tasks */
-    xTaskCreate(lora_rx_task,  "lora_rx_task",  4096, NULL, 5, NULL);
-    xTaskCreate(display_task,  "display_task",   4096, NULL, 4, NULL);
+    /* Create FreeRTOS tasks - readout above decode so bursts land in the ring */
+    xTaskCreate(lora_rx_task,   "lora_rx_task",   4096, NULL, 6, NULL);
+    xTaskCreate(rx_decode_task, "rx_decode_task", 4096, NULL, 5, NULL);
+    xTaskCreate(display_task,   "display_task",   4096, NULL, 4, NULL);
 
     ESP_LOGI(TAG, "All tasks started - receiver running");
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""
+Generate shared/protocol/crc16_table.h
+
+CRC16-CCITT (poly 0x1021, MSB first) lookup tables for the table-driven
+and slice-by-4/8 engines in crc16.c. Row k holds the CRC of byte n
+followed by k zero bytes, so slice-by-N folds N input bytes per step.
+
+Usage: python3 scripts/gen_crc16_tables.py > shared/protocol/crc16_table.h
+"""
+
+POLY = 0x1021
+SLICES = 8
+
+
+def crc_byte(n):
+    crc = n << 8
+    for _ in range(8):
+        crc = ((crc << 1) ^ POLY) if crc & 0x8000 else (crc << 1)
+    return crc & 0xFFFF
+
+
+def build_tables():
+    tables = [[crc_byte(n) for n in range(256)]]
+    for k in range(1, SLICES):
+        prev = tables[k - 1]
+        tables.append([((prev[n] << 8) & 0xFFFF) ^ tables[0][prev[n] >> 8]
+                       for n in range(256)])
+    return tables
+
+
+def emit_row(row):
+    lines = []
+    for i in range(0, 256, 8):
+        lines.append("        " + ", ".join("0x%04X" % v for v in row[i:i + 8]) + ",")
+    return "\n".join(lines)
+
+
+def main():
+    tables = build_tables()
+    out = []
+    out.append("/* Generated by scripts/gen_crc16_tables.py - do not edit */")
+    out.append("#ifndef CRC16_TABLE_H")
+    out.append("#define CRC16_TABLE_H")
+    out.append("")
+    out.append("#include <stdint.h>")
+    out.append("")
+    out.append("/* CRC16_SLICES must be 1, 4 or 8 before including this header */")
+    out.append("static const uint16_t s_crc16_table[CRC16_SLICES][256] = {")
+    for k, row in enumerate(tables):
+        if k == 1:
+            out.append("#if CRC16_SLICES > 1")
+        if k == 4:
+            out.append("#endif")
+            out.append("#if CRC16_SLICES > 4")
+        out.append("    {   /* T%d */" % k)
+        out.append(emit_row(row))
+        out.append("    },")
+    out.append("#endif")
+    out.append("};")
+    out.append("")
+    out.append("#endif /* CRC16_TABLE_H */")
+    print("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,133 @@
+#include "adr.h"
+
+/* SX1262 demodulator SNR floor and sensitivity at BW 125 kHz, SF7..SF12
+ * (datasheet tables 6-3 / 3-5) */
+static const int8_t s_required_snr_qdb[6] = { -30, -40, -50, -60, -70, -80 };
+static const int16_t s_sensitivity_dbm[6] = { -124, -127, -130, -133, -135, -137 };
+
+static uint8_t sf_index(uint8_t sf)
+{
+    if (sf < ADR_SF_MIN) {
+        return 0;
+    }
+    if (sf > ADR_SF_MAX) {
+        return ADR_SF_MAX - ADR_SF_MIN;
+    }
+    return (uint8_t)(sf - ADR_SF_MIN);
+}
+
+int adr_required_snr_qdb(uint8_t sf)
+{
+    return s_required_snr_qdb[sf_index(sf)];
+}
+
+int adr_sensitivity_dbm(uint8_t sf)
+{
+    return s_sensitivity_dbm[sf_index(sf)];
+}
+
+void adr_link_init(adr_link_t *l, adr_setting_t start)
+{
+    l->current       = start;
+    l->count         = 0;
+    l->next          = 0;
+    l->since_command = 0;
+}
+
+void adr_link_observe(adr_link_t *l, int snr_qdb, int rssi_dbm)
+{
+    if (snr_qdb < -128) {
+        snr_qdb = -128;
+    } else if (snr_qdb > 127) {
+        snr_qdb = 127;
+    }
+
+    l->snr_qdb[l->next]  = (int8_t)snr_qdb;
+    l->rssi_dbm[l->next] = (int16_t)rssi_dbm;
+    l->next = (uint8_t)((l->next + 1) % ADR_HISTORY);
+    if (l->count < ADR_HISTORY) {
+        l->count++;
+    }
+}
+
+int adr_link_margin_db(const adr_link_t *l)
+{
+    if (l->count == 0) {
+        return 0;
+    }
+
+    int snr_max  = -128;
+    int rssi_max = -32768;
+    for (uint8_t i = 0; i < l->count; i++) {
+        if (l->snr_qdb[i] > snr_max) {
+            snr_max = l->snr_qdb[i];
+        }
+        if (l->rssi_dbm[i] > rssi_max) {
+            rssi_max = l->rssi_dbm[i];
+        }
+    }
+
+    int margin = (snr_max - adr_required_snr_qdb(l->current.sf)) / 4;
+
+    /* Strong signal: SNR no longer grows with it, RSSI still does */
+    if (snr_max >= ADR_SNR_SATURATED_QDB) {
+        int rssi_margin = rssi_max - adr_sensitivity_dbm(l->current.sf);
+        if (rssi_margin > margin) {
+            margin = rssi_margin;
+        }
+    }
+    return margin;
+}
+
+bool adr_link_decide(adr_link_t *l, adr_setting_t *next)
+{
+    *next = l->current;
+    if (l->since_command < 255) {
+        l->since_command++;
+    }
+
+    if (l->count == ADR_HISTORY) {
+        int spare = adr_link_margin_db(l) - ADR_MARGIN_DB;
+
+        /* Round toward minus infinity: any deficit is at least one step */
+        int steps = (spare >= 0) ? spare / ADR_STEP_DB
+                                 : -((-spare + ADR_STEP_DB - 1) / ADR_STEP_DB);
+
+        while (steps > 0 && ADR_ADAPT_SF && next->sf > ADR_SF_MIN) {
+            next->sf--;
+            steps--;
+        }
+        while (steps > 0 && next->tx_power_dbm > ADR_POWER_MIN_DBM) {
+            next->tx_power_dbm -= ADR_STEP_DB;
+            steps--;
+        }
+        while (steps < 0 && next->tx_power_dbm < ADR_POWER_MAX_DBM) {
+            next->tx_power_dbm += ADR_STEP_DB;
+            steps++;
+        }
+        while (steps < 0 && ADR_ADAPT_SF && next->sf < ADR_SF_MAX) {
+            next->sf++;
+            steps++;
+        }
+
+        if (next->tx_power_dbm < ADR_POWER_MIN_DBM) {
+            next->tx_power_dbm = ADR_POWER_MIN_DBM;
+        } else if (next->tx_power_dbm > ADR_POWER_MAX_DBM) {
+            next->tx_power_dbm = ADR_POWER_MAX_DBM;
+        }
+    }
+
+    bool changed = next->sf != l->current.sf ||
+                   next->tx_power_dbm != l->current.tx_power_dbm;
+    if (changed) {
+        l->current = *next;
+        l->count   = 0;
+        l->next    = 0;
+    }
+
+    if (changed || l->since_command >= ADR_CONFIRM_FRAMES) {
+        l->since_command = 0;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,116 @@
+#ifndef ADR_H
+#define ADR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Adaptive data rate. The receiver measures each node's SNR/RSSI and
+ * commands the lowest SF and TX power that still leave ADR_MARGIN_DB of
+ * link margin. Both nodes build this header.
+ */
+#define ADR_LINK_ENABLED       0
+
+/* Adapt SF as well as power. The SX1262 demodulates one SF at a time,
+ * so the receiver switches along with the node: point-to-point links
+ * only. With several transmitters set 0 to adapt TX power alone. */
+#define ADR_ADAPT_SF           1
+
+/* Margin kept above the demodulation floor (fading, antenna changes) */
+#define ADR_MARGIN_DB          10
+
+/* Margin traded per step: one SF, or ADR_STEP_DB of TX power */
+#define ADR_STEP_DB            3
+
+/* Decisions use the best of this many frames at the current setting */
+#define ADR_HISTORY            8
+
+#define ADR_SF_MIN             7
+#define ADR_SF_MAX             12
+#define ADR_POWER_MIN_DBM      2
+#define ADR_POWER_MAX_DBM      20   /* Same as LORA_TX_POWER */
+
+/* Above this SNR (quarter dB) the radio's SNR estimate saturates and
+ * RSSI against sensitivity tracks the margin instead */
+#define ADR_SNR_SATURATED_QDB  (8 * 4)
+
+/* Receiver repeats the current command at least every this many frames */
+#define ADR_CONFIRM_FRAMES     8
+
+/* Transmitter reverts to its base config after this many frames without
+ * any downlink (lost command or receiver on another SF) */
+#define ADR_ACK_LIMIT          24
+
+/* Receiver reverts to its base SF after this long without a frame */
+#define ADR_FALLBACK_MS        (5 * 60 * 1000)
+
+/* Transmitter listens this long for a command after each frame */
+#define ADR_RX_WINDOW_MS       150
+
+/**
+ * @brief Spreading factor and TX power assigned to a node
+ */
+typedef struct {
+    uint8_t sf;
+    int8_t  tx_power_dbm;
+} adr_setting_t;
+
+/**
+ * @brief Receiver-side ADR state for one node (no heap, O(ADR_HISTORY))
+ */
+typedef struct {
+    adr_setting_t current;                /* Last setting commanded        */
+    int8_t   snr_qdb[ADR_HISTORY];        /* SNR of recent frames, 0.25 dB */
+    int16_t  rssi_dbm[ADR_HISTORY];       /* RSSI of the same frames       */
+    uint8_t  count;                       /* Valid history entries         */
+    uint8_t  next;                        /* Ring write index              */
+    uint8_t  since_command;               /* Frames since the last command */
+} adr_link_t;
+
+/**
+ * @brief Reset a node's state
+ * @param l     Node state
+ * @param start Setting the node transmits with before any command
+ */
+void adr_link_init(adr_link_t *l, adr_setting_t start);
+
+/**
+ * @brief Record the link quality of one received frame
+ * @param l        Node state
+ * @param snr_qdb  Packet SNR in 0.25 dB units (SX126x GET_PKT_STATUS)
+ * @param rssi_dbm Packet RSSI in dBm
+ */
+void adr_link_observe(adr_link_t *l, int snr_qdb, int rssi_dbm);
+
+/**
+ * @brief Link margin above the demodulation floor at the current setting
+ * @return Margin in dB from the best recent frame (0 without history)
+ */
+int adr_link_margin_db(const adr_link_t *l);
+
+/**
+ * @brief Decide the node's next setting after a frame was observed
+ *
+ * Spare margin lowers SF first (shorter airtime), then TX power; a
+ * deficit raises TX power first, then SF. A change clears the history,
+ * since old frames were measured at the old setting.
+ *
+ * @param l    Node state (current is updated on a change)
+ * @param next Setting to command
+ * @return true if a command should be sent now (changed, or confirm due)
+ */
+bool adr_link_decide(adr_link_t *l, adr_setting_t *next);
+
+/**
+ * @brief SNR needed to demodulate at a spreading factor
+ * @return Required SNR in 0.25 dB units
+ */
+int adr_required_snr_qdb(uint8_t sf);
+
+/**
+ * @brief Receiver sensitivity at a spreading factor (BW 125 kHz)
+ * @return Sensitivity in dBm
+ */
+int adr_sensitivity_dbm(uint8_t sf);
+
+#endif /* ADR_H */
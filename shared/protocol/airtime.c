@@ -0,0 +1,34 @@
+#include "airtime.h"
+
+uint32_t airtime_lora_us(const airtime_params_t *p, uint8_t payload_len)
+{
+    /* Symbol time in microseconds, kept x16 to stay in integer math */
+    uint64_t tsym_x16 = ((uint64_t)16000000 << p->sf) / p->bw_hz;
+    bool     ldro     = tsym_x16 >= 16 * 16000;
+
+    /* payloadSymbNb = 8 + max(ceil(num / den) * (CR + 4), 0) */
+    int32_t num = 8 * payload_len - 4 * p->sf + 28
+                + (p->crc_on ? 16 : 0) - (p->implicit_header ? 20 : 0);
+    int32_t den = 4 * (p->sf - (ldro ? 2 : 0));
+    int32_t sym = 8;
+    if (num > 0) {
+        sym += ((num + den - 1) / den) * (p->cr + 4);
+    }
+
+    /* Preamble adds 4.25 symbols for the sync word and SFD */
+    uint64_t total_x4 = (uint64_t)p->preamble * 4 + 17 + (uint64_t)sym * 4;
+    return (uint32_t)((total_x4 * tsym_x16) / 64);
+}
+
+void airtime_rx_duty_cycle(const airtime_params_t *p, uint16_t rx_symbols,
+                           uint32_t wake_us, uint32_t *rx_us, uint32_t *sleep_us)
+{
+    uint64_t tsym_x16 = ((uint64_t)16000000 << p->sf) / p->bw_hz;
+
+    *rx_us = (uint32_t)((rx_symbols * tsym_x16) / 16);
+
+    /* Worst case the preamble starts just after a window opened */
+    uint64_t preamble_us = ((uint64_t)p->preamble * tsym_x16) / 16;
+    uint64_t awake_us    = 2 * (uint64_t)*rx_us + wake_us;
+    *sleep_us = preamble_us > awake_us ? (uint32_t)(preamble_us - awake_us) : 0;
+}
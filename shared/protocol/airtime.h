@@ -0,0 +1,49 @@
+#ifndef AIRTIME_H
+#define AIRTIME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief LoRa modem parameters that determine time-on-air
+ */
+typedef struct {
+    uint8_t  sf;              /* Spreading factor 7-12          */
+    uint32_t bw_hz;           /* Bandwidth in Hz (125000, ...)  */
+    uint8_t  cr;              /* Coding rate 1-4 => 4/5 .. 4/8  */
+    uint16_t preamble;        /* Preamble length in symbols     */
+    bool     implicit_header; /* true = no PHY header           */
+    bool     crc_on;          /* Radio payload CRC enabled      */
+} airtime_params_t;
+
+/**
+ * @brief Time-on-air of one LoRa frame (Semtech AN1200.13 formula)
+ *
+ * Low data rate optimization is assumed on when the symbol time is
+ * 16 ms or longer, which is what the SX1262 requires.
+ *
+ * @param p           Modem parameters
+ * @param payload_len Payload length in bytes
+ * @return Time-on-air in microseconds
+ */
+uint32_t airtime_lora_us(const airtime_params_t *p, uint8_t payload_len);
+
+/**
+ * @brief Listen/sleep periods for SX126x duty-cycled RX (SetRxDutyCycle)
+ *
+ * The receiver listens for rx_symbols, then sleeps. A frame is caught
+ * as long as its preamble spans one whole cycle (wake-up, sleep and
+ * listen window) plus one more window, so the sleep is derived from the
+ * preamble in p, which is the transmitter's preamble length.
+ *
+ * @param p          Modem parameters (preamble = transmitter's, symbols)
+ * @param rx_symbols Listen window in symbols
+ * @param wake_us    Radio start-up before each window (e.g. TCXO)
+ * @param rx_us      Listen window in microseconds
+ * @param sleep_us   Sleep period in microseconds (0: preamble too short
+ *                   for duty cycling, listen continuously)
+ */
+void airtime_rx_duty_cycle(const airtime_params_t *p, uint16_t rx_symbols,
+                           uint32_t wake_us, uint32_t *rx_us, uint32_t *sleep_us);
+
+#endif /* AIRTIME_H */
@@ -0,0 +1,105 @@
+#include "arq.h"
+#include <string.h>
+
+void arq_init(arq_window_t *w)
+{
+    memset(w, 0, sizeof(*w));
+}
+
+void arq_push(arq_window_t *w, const lora_packet_t *pkts, uint8_t count,
+              uint32_t now_ms)
+{
+    if (count == 0 || count > PACKET_AGG_MAX_EVENTS) {
+        return;
+    }
+
+    /* Free slot, or else the oldest frame */
+    arq_entry_t *slot = &w->entries[0];
+    for (int i = 0; i < ARQ_WINDOW_SIZE; i++) {
+        arq_entry_t *e = &w->entries[i];
+        if (!e->used) {
+            slot = e;
+            break;
+        }
+        if ((int32_t)(e->first_ms - slot->first_ms) < 0) {
+            slot = e;
+        }
+    }
+    if (slot->used) {
+        w->failed++;
+    }
+
+    slot->used     = true;
+    slot->count    = count;
+    slot->retries  = 0;
+    slot->first_ms = now_ms;
+    slot->due_ms   = now_ms + ARQ_BACKOFF_BASE_MS;
+    memcpy(slot->pkts, pkts, count * sizeof(lora_packet_t));
+}
+
+uint8_t arq_on_ack(arq_window_t *w, const packet_ack_t *ack)
+{
+    uint8_t released = 0;
+
+    for (int i = 0; i < ARQ_WINDOW_SIZE; i++) {
+        arq_entry_t *e = &w->entries[i];
+        if (!e->used || e->pkts[0].node_id != ack->node_id) {
+            continue;
+        }
+
+        bool all = true;
+        for (uint8_t k = 0; k < e->count && all; k++) {
+            all = packet_ack_covers(ack, e->pkts[k].seq);
+        }
+
+        if (all) {
+            e->used = false;
+            w->delivered++;
+            released++;
+        }
+    }
+
+    return released;
+}
+
+arq_entry_t *arq_next_due(arq_window_t *w, uint32_t now_ms)
+{
+    for (int i = 0; i < ARQ_WINDOW_SIZE; i++) {
+        arq_entry_t *e = &w->entries[i];
+        if (!e->used || (int32_t)(now_ms - e->due_ms) < 0) {
+            continue;
+        }
+        if (e->retries >= ARQ_MAX_RETRIES) {
+            e->used = false;
+            w->failed++;
+            continue;
+        }
+        return e;
+    }
+    return NULL;
+}
+
+void arq_mark_resent(arq_window_t *w, arq_entry_t *e, uint32_t now_ms)
+{
+    e->retries++;
+    e->due_ms = now_ms + ((uint32_t)ARQ_BACKOFF_BASE_MS << e->retries);
+    w->retransmits++;
+}
+
+uint32_t arq_ms_until_due(const arq_window_t *w, uint32_t now_ms)
+{
+    uint32_t best = UINT32_MAX;
+
+    for (int i = 0; i < ARQ_WINDOW_SIZE; i++) {
+        const arq_entry_t *e = &w->entries[i];
+        if (!e->used) {
+            continue;
+        }
+        int32_t left = (int32_t)(e->due_ms - now_ms);
+        uint32_t ms  = (left > 0) ? (uint32_t)left : 0;
+        if (ms < best) {
+            best = ms;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,93 @@
+#ifndef ARQ_H
+#define ARQ_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "packet.h"
+
+/*
+ * Selective-repeat ARQ. Both nodes build this header, so the receiver
+ * ACKs exactly when the transmitter expects it.
+ */
+#define ARQ_LINK_ENABLED       0
+
+/* Unacknowledged frames the transmitter keeps for retransmission */
+#define ARQ_WINDOW_SIZE        4
+
+/* How long the transmitter listens for an ACK after each frame (ms) */
+#define ARQ_ACK_TIMEOUT_MS     150
+
+/* First retransmission delay, doubled on every retry (ms) */
+#define ARQ_BACKOFF_BASE_MS    400
+
+/* Retransmissions before a frame is given up */
+#define ARQ_MAX_RETRIES        3
+
+/**
+ * @brief One transmitted frame awaiting acknowledgement
+ */
+typedef struct {
+    bool          used;
+    uint8_t       count;                        /* Events in the frame   */
+    uint8_t       retries;                      /* Retransmissions so far*/
+    uint32_t      first_ms;                     /* First send time       */
+    uint32_t      due_ms;                       /* Next retransmission   */
+    lora_packet_t pkts[PACKET_AGG_MAX_EVENTS];  /* Events, oldest first  */
+} arq_entry_t;
+
+/**
+ * @brief Transmitter sliding window and delivery counters
+ */
+typedef struct {
+    arq_entry_t entries[ARQ_WINDOW_SIZE];
+    uint32_t    delivered;      /* Frames acknowledged               */
+    uint32_t    retransmits;    /* Retransmissions sent              */
+    uint32_t    failed;         /* Frames given up or evicted        */
+} arq_window_t;
+
+/**
+ * @brief Reset the window and counters
+ */
+void arq_init(arq_window_t *w);
+
+/**
+ * @brief Track a frame that was just sent for the first time
+ *
+ * When the window is full the oldest frame is evicted and counted as
+ * failed, so new events are never blocked behind old ones.
+ *
+ * @param w      Window
+ * @param pkts   Events carried by the frame (must have sequence numbers)
+ * @param count  Number of events (1..PACKET_AGG_MAX_EVENTS)
+ * @param now_ms Current time in ms
+ */
+void arq_push(arq_window_t *w, const lora_packet_t *pkts, uint8_t count,
+              uint32_t now_ms);
+
+/**
+ * @brief Release every frame whose events are all covered by an ACK
+ * @return Number of frames released
+ */
+uint8_t arq_on_ack(arq_window_t *w, const packet_ack_t *ack);
+
+/**
+ * @brief Get the next frame whose retransmission is due
+ *
+ * Frames that already used ARQ_MAX_RETRIES are dropped here.
+ *
+ * @return Entry to resend (then call arq_mark_resent), NULL if none is due
+ */
+arq_entry_t *arq_next_due(arq_window_t *w, uint32_t now_ms);
+
+/**
+ * @brief Record a retransmission and back off exponentially
+ */
+void arq_mark_resent(arq_window_t *w, arq_entry_t *e, uint32_t now_ms);
+
+/**
+ * @brief Time until the next retransmission is due
+ * @return Milliseconds, UINT32_MAX if the window is empty
+ */
+uint32_t arq_ms_until_due(const arq_window_t *w, uint32_t now_ms);
+
+#endif /* ARQ_H */
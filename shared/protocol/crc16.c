@@ -1,20 +1,77 @@
 #include "crc16.h"
 
-uint16_t crc16_calculate(const uint8_t *data, uint16_t length)
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+/* Engine selection: 1 = byte table (512 B), 4/8 = slice-by-N (2/4 KB) */
+#ifndef CRC16_SLICES
+#if defined(CONFIG_PROTOCOL_CRC16_SLICE8)
+#define CRC16_SLICES  8
+#elif defined(CONFIG_PROTOCOL_CRC16_SLICE4)
+#define CRC16_SLICES  4
+#else
+#define CRC16_SLICES  1
+#endif
+#endif
+
+#if CRC16_SLICES != 1 && CRC16_SLICES != 4 && CRC16_SLICES != 8
+#error "CRC16_SLICES must be 1, 4 or 8"
+#endif
+
+#include "crc16_table.h"
+
+/* One byte through the table: same result as 8 shift/xor rounds */
+#define CRC16_STEP(crc, byte) \
+    (uint16_t)(((crc) << 8) ^ s_crc16_table[0][(uint8_t)(((crc) >> 8) ^ (byte))])
+
+uint16_t crc16_init(void)
+{
+    return CRC16_INIT;
+}
+
+uint16_t crc16_update(uint16_t crc, const uint8_t *data, uint16_t length)
 {
-    uint16_t crc = 0xFFFF;
-
-    for (uint16_t i = 0; i < length; i++) {
-        crc ^= (uint16_t)data[i] << 8;
-
-        for (uint8_t bit = 0; bit < 8; bit++) {
-            if (crc & 0x8000) {
-                crc = (crc << 1) ^ 0x1021;
-            } else {
-                crc <<= 1;
-            }
-        }
+#if CRC16_SLICES == 8
+    while (length >= 8) {
+        crc = s_crc16_table[7][data[0] ^ (crc >> 8)]   ^
+              s_crc16_table[6][data[1] ^ (crc & 0xFF)] ^
+              s_crc16_table[5][data[2]] ^
+              s_crc16_table[4][data[3]] ^
+              s_crc16_table[3][data[4]] ^
+              s_crc16_table[2][data[5]] ^
+              s_crc16_table[1][data[6]] ^
+              s_crc16_table[0][data[7]];
+        data   += 8;
+        length -= 8;
+    }
+#endif
+
+#if CRC16_SLICES >= 4
+    while (length >= 4) {
+        crc = s_crc16_table[3][data[0] ^ (crc >> 8)]   ^
+              s_crc16_table[2][data[1] ^ (crc & 0xFF)] ^
+              s_crc16_table[1][data[2]] ^
+              s_crc16_table[0][data[3]];
+        data   += 4;
+        length -= 4;
+    }
+#endif
+
+    while (length--) {
+        crc = CRC16_STEP(crc, *data++);
     }
 
     return crc;
-}
\ No newline at end of file
+}
+
+uint16_t crc16_final(uint16_t crc)
+{
+    /* CCITT-FALSE has no output XOR */
+    return crc;
+}
+
+uint16_t crc16_calculate(const uint8_t *data, uint16_t length)
+{
+    return crc16_final(crc16_update(crc16_init(), data, length));
+}
@@ -3,12 +3,41 @@
 
 #include <stdint.h>
 
+/* CRC16-CCITT initial register value */
+#define CRC16_INIT  0xFFFF
+
+/**
+ * @brief Start an incremental CRC16-CCITT computation
+ * @return Initial CRC register value
+ */
+uint16_t crc16_init(void);
+
+/**
+ * @brief Feed bytes into an incremental CRC16-CCITT computation
+ * @param crc    Running CRC from crc16_init() or a previous update
+ * @param data   Pointer to the next chunk
+ * @param length Number of bytes in the chunk
+ * @return Updated running CRC
+ */
+uint16_t crc16_update(uint16_t crc, const uint8_t *data, uint16_t length);
+
+/**
+ * @brief Finish an incremental CRC16-CCITT computation
+ * @param crc Running CRC after the last update
+ * @return Final CRC16
+ */
+uint16_t crc16_final(uint16_t crc);
+
 /**
  * @brief Calculate CRC16-CCITT of a data buffer
+ *
+ * Table-driven; byte table or slice-by-4/8 is chosen in menuconfig
+ * (LoRa Protocol -> CRC16-CCITT engine).
+ *
  * @param data   Pointer to the buffer
  * @param length Number of bytes
  * @return Calculated CRC16
  */
 uint16_t crc16_calculate(const uint8_t *data, uint16_t length);
 
-#endif /* CRC16_H */
\ No newline at end of file
+#endif /* CRC16_H */
@@ -0,0 +1,81 @@
+#include "duty_cycle.h"
+#include <string.h>
+
+#define DUTY_CYCLE_CAPACITY_US  ((int32_t)DUTY_CYCLE_BURST_MS * 1000)
+#define DUTY_CYCLE_RESERVE_US   ((int32_t)DUTY_CYCLE_RESERVE_MS * 1000)
+
+#if DUTY_CYCLE_PERMILLE < 1 || DUTY_CYCLE_PERMILLE > 1000
+#error "DUTY_CYCLE_PERMILLE must be 1..1000"
+#endif
+#if DUTY_CYCLE_RESERVE_MS >= DUTY_CYCLE_BURST_MS
+#error "DUTY_CYCLE_RESERVE_MS must be below DUTY_CYCLE_BURST_MS"
+#endif
+
+/* permille of each elapsed ms is exactly permille µs of airtime */
+static void refill(duty_cycle_t *dc, uint32_t now_ms)
+{
+    uint32_t elapsed = now_ms - dc->last_ms;
+    dc->last_ms = now_ms;
+
+    int64_t tokens = (int64_t)dc->tokens_us + (int64_t)elapsed * DUTY_CYCLE_PERMILLE;
+    dc->tokens_us = (tokens > DUTY_CYCLE_CAPACITY_US) ? DUTY_CYCLE_CAPACITY_US
+                                                      : (int32_t)tokens;
+}
+
+void duty_cycle_init(duty_cycle_t *dc, uint32_t now_ms)
+{
+    memset(dc, 0, sizeof(*dc));
+    dc->tokens_us = DUTY_CYCLE_CAPACITY_US;
+    dc->last_ms   = now_ms;
+}
+
+uint32_t duty_cycle_wait_ms(duty_cycle_t *dc, uint32_t airtime_us, bool urgent,
+                            uint32_t now_ms)
+{
+#if DUTY_CYCLE_ENABLED
+    refill(dc, now_ms);
+
+    int64_t need = (int64_t)airtime_us + (urgent ? 0 : DUTY_CYCLE_RESERVE_US);
+    if (need > DUTY_CYCLE_CAPACITY_US) {
+        need = DUTY_CYCLE_CAPACITY_US;
+    }
+    if (dc->tokens_us >= need) {
+        return 0;
+    }
+
+    if (!dc->deferring) {
+        dc->deferring      = true;
+        dc->defer_start_ms = now_ms;
+        dc->deferred++;
+    }
+    return (uint32_t)((need - dc->tokens_us + DUTY_CYCLE_PERMILLE - 1) /
+                      DUTY_CYCLE_PERMILLE);
+#else
+    (void)dc;
+    (void)airtime_us;
+    (void)urgent;
+    (void)now_ms;
+    return 0;
+#endif
+}
+
+void duty_cycle_consume(duty_cycle_t *dc, uint32_t airtime_us, uint32_t now_ms)
+{
+    refill(dc, now_ms);
+
+    int64_t tokens = (int64_t)dc->tokens_us - airtime_us;
+    dc->tokens_us = (tokens < INT32_MIN) ? INT32_MIN : (int32_t)tokens;
+    dc->airtime_us += airtime_us;
+    dc->frames++;
+
+    if (dc->deferring) {
+        dc->deferring    = false;
+        dc->deferred_ms += now_ms - dc->defer_start_ms;
+    }
+}
+
+uint32_t duty_cycle_available_us(duty_cycle_t *dc, uint32_t now_ms)
+{
+    refill(dc, now_ms);
+    return dc->tokens_us > 0 ? (uint32_t)dc->tokens_us : 0;
+}
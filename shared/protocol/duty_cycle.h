@@ -0,0 +1,77 @@
+#ifndef DUTY_CYCLE_H
+#define DUTY_CYCLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Airtime budget for the transmitter: a token bucket refilled at
+ * DUTY_CYCLE_PERMILLE of wall time, spent by each frame's time-on-air.
+ * Airtime is always counted; the budget is only enforced when enabled.
+ * Off by default: the link runs at 915 MHz, where US915 sets no duty
+ * cycle. Enable it for EU868.
+ */
+#define DUTY_CYCLE_ENABLED       0
+
+/* Allowed share of channel time: 10 = 1 % (EU868 g/g1 sub-bands) */
+#define DUTY_CYCLE_PERMILLE      10
+
+/* Bucket depth: the longest burst allowed after an idle period (ms of
+ * airtime). 3600 ms = six minutes' worth at 1 %. */
+#define DUTY_CYCLE_BURST_MS      3600
+
+/* Part of the bucket only urgent frames may spend (ms of airtime) */
+#define DUTY_CYCLE_RESERVE_MS    1200
+
+/* Longest single frame allowed on air, 0 = no limit (US915: 400) */
+#define DUTY_CYCLE_MAX_DWELL_MS  0
+
+/**
+ * @brief Token bucket state and airtime counters
+ */
+typedef struct {
+    int32_t  tokens_us;      /* Airtime available; negative = in debt  */
+    uint32_t last_ms;        /* Last refill time                       */
+    uint64_t airtime_us;     /* Airtime used since init                */
+    uint32_t frames;         /* Frames counted                         */
+    uint32_t deferred;       /* Sends that had to wait for budget      */
+    uint32_t deferred_ms;    /* Total time those sends waited          */
+    bool     deferring;      /* A send is currently waiting            */
+    uint32_t defer_start_ms; /* When it started waiting                */
+} duty_cycle_t;
+
+/**
+ * @brief Reset counters and start with a full bucket
+ * @param now_ms Current time in ms
+ */
+void duty_cycle_init(duty_cycle_t *dc, uint32_t now_ms);
+
+/**
+ * @brief Time until a frame fits in the budget
+ *
+ * Non-urgent frames must leave DUTY_CYCLE_RESERVE_MS in the bucket. A
+ * frame longer than the whole bucket waits for a full bucket and then
+ * goes into debt, so it is delayed but never starved.
+ *
+ * @param airtime_us Time-on-air of the frame(s) to send
+ * @param urgent     May spend the reserve
+ * @param now_ms     Current time in ms
+ * @return 0 to send now, else milliseconds to wait
+ */
+uint32_t duty_cycle_wait_ms(duty_cycle_t *dc, uint32_t airtime_us, bool urgent,
+                            uint32_t now_ms);
+
+/**
+ * @brief Charge a frame that went on air
+ * @param airtime_us Its time-on-air
+ * @param now_ms     Current time in ms
+ */
+void duty_cycle_consume(duty_cycle_t *dc, uint32_t airtime_us, uint32_t now_ms);
+
+/**
+ * @brief Airtime currently available in the bucket
+ * @return Microseconds (0 when in debt)
+ */
+uint32_t duty_cycle_available_us(duty_cycle_t *dc, uint32_t now_ms);
+
+#endif /* DUTY_CYCLE_H */
@@ -0,0 +1,212 @@
+#include "fec.h"
+#include <stdbool.h>
+#include <string.h>
+
+/* GF(256) with primitive polynomial x^8 + x^4 + x^3 + x^2 + 1 */
+#define GF_POLY  0x11D
+
+static uint8_t s_exp[512];
+static uint8_t s_log[256];
+static bool    s_ready = false;
+
+static void gf_init(void)
+{
+    if (s_ready) {
+        return;
+    }
+
+    uint16_t x = 1;
+    for (int i = 0; i < 255; i++) {
+        s_exp[i] = (uint8_t)x;
+        s_log[x] = (uint8_t)i;
+        x <<= 1;
+        if (x & 0x100) {
+            x ^= GF_POLY;
+        }
+    }
+    /* Doubled so products never need a modulo */
+    for (int i = 255; i < 512; i++) {
+        s_exp[i] = s_exp[i - 255];
+    }
+    s_ready = true;
+}
+
+static inline uint8_t gf_mul(uint8_t a, uint8_t b)
+{
+    if (a == 0 || b == 0) {
+        return 0;
+    }
+    return s_exp[s_log[a] + s_log[b]];
+}
+
+static inline uint8_t gf_div(uint8_t a, uint8_t b)
+{
+    if (a == 0) {
+        return 0;
+    }
+    return s_exp[s_log[a] + 255 - s_log[b]];
+}
+
+/* Evaluate poly (low degree first) at x */
+static uint8_t poly_eval(const uint8_t *p, int len, uint8_t x)
+{
+    uint8_t y = 0;
+    for (int i = len - 1; i >= 0; i--) {
+        y = gf_mul(y, x) ^ p[i];
+    }
+    return y;
+}
+
+/* g(x) = (x - a^0)(x - a^1)...(x - a^(parity-1)), high degree first */
+static void rs_generator(uint8_t *gen, uint8_t parity)
+{
+    memset(gen, 0, parity + 1);
+    gen[0] = 1;
+    for (uint8_t i = 0; i < parity; i++) {
+        for (int j = i + 1; j > 0; j--) {
+            gen[j] ^= gf_mul(gen[j - 1], s_exp[i]);
+        }
+    }
+}
+
+uint8_t fec_encode(uint8_t *buffer, uint8_t length, uint8_t parity)
+{
+    if (parity == 0 || parity > FEC_MAX_PARITY || (parity % 2) != 0 ||
+        (uint16_t)length + parity > 255) {
+        return 0;
+    }
+    gf_init();
+
+    uint8_t gen[FEC_MAX_PARITY + 1];
+    rs_generator(gen, parity);
+
+    /* LFSR division: remainder of msg(x) * x^parity by g(x) */
+    uint8_t *rem = &buffer[length];
+    memset(rem, 0, parity);
+    for (uint8_t i = 0; i < length; i++) {
+        uint8_t fb = buffer[i] ^ rem[0];
+        memmove(rem, rem + 1, parity - 1);
+        rem[parity - 1] = 0;
+        if (fb != 0) {
+            for (uint8_t j = 0; j < parity; j++) {
+                rem[j] ^= gf_mul(gen[j + 1], fb);
+            }
+        }
+    }
+
+    return length + parity;
+}
+
+int fec_decode(uint8_t *buffer, uint8_t length, uint8_t parity)
+{
+    if (parity == 0 || parity > FEC_MAX_PARITY || (parity % 2) != 0 ||
+        length <= parity) {
+        return -1;
+    }
+    gf_init();
+
+    /* Syndromes S_j = r(a^j); byte i has degree length-1-i */
+    uint8_t synd[FEC_MAX_PARITY];
+    bool    clean = true;
+    for (uint8_t j = 0; j < parity; j++) {
+        uint8_t s = 0;
+        for (uint8_t i = 0; i < length; i++) {
+            s = gf_mul(s, s_exp[j]) ^ buffer[i];
+        }
+        synd[j] = s;
+        clean &= (s == 0);
+    }
+    if (clean) {
+        return 0;
+    }
+
+    /* Berlekamp-Massey: error locator lambda(x), low degree first */
+    uint8_t lambda[FEC_MAX_PARITY + 1] = { 1 };
+    uint8_t prev[FEC_MAX_PARITY + 1]   = { 1 };
+    uint8_t tmp[FEC_MAX_PARITY + 1];
+    int     errs = 0;
+    int     m    = 1;
+    uint8_t b    = 1;
+
+    for (int n = 0; n < parity; n++) {
+        uint8_t d = synd[n];
+        for (int i = 1; i <= errs; i++) {
+            d ^= gf_mul(lambda[i], synd[n - i]);
+        }
+
+        if (d == 0) {
+            m++;
+            continue;
+        }
+
+        uint8_t coef = gf_div(d, b);
+        memcpy(tmp, lambda, sizeof(tmp));
+        for (int i = 0; i + m <= parity; i++) {
+            lambda[i + m] ^= gf_mul(coef, prev[i]);
+        }
+
+        if (2 * errs <= n) {
+            errs = n + 1 - errs;
+            memcpy(prev, tmp, sizeof(prev));
+            b = d;
+            m = 1;
+        } else {
+            m++;
+        }
+    }
+
+    if (errs > parity / 2) {
+        return -1;
+    }
+
+    /* Error evaluator omega(x) = S(x) * lambda(x) mod x^parity */
+    uint8_t omega[FEC_MAX_PARITY];
+    for (int k = 0; k < parity; k++) {
+        uint8_t v = 0;
+        for (int j = 0; j <= k && j <= errs; j++) {
+            v ^= gf_mul(synd[k - j], lambda[j]);
+        }
+        omega[k] = v;
+    }
+
+    /* Formal derivative: only odd-degree terms survive in GF(2^m) */
+    uint8_t dlambda[FEC_MAX_PARITY];
+    memset(dlambda, 0, sizeof(dlambda));
+    for (int i = 1; i <= errs; i += 2) {
+        dlambda[i - 1] = lambda[i];
+    }
+
+    /* Chien search + Forney; nothing is written until every root is found */
+    uint8_t pos[FEC_MAX_PARITY / 2];
+    uint8_t mag[FEC_MAX_PARITY / 2];
+    int     found = 0;
+
+    for (int i = 0; i < length; i++) {
+        int     power = length - 1 - i;
+        uint8_t xinv  = s_exp[(255 - power) % 255];
+        if (poly_eval(lambda, errs + 1, xinv) != 0) {
+            continue;
+        }
+        if (found == errs) {
+            return -1;
+        }
+
+        uint8_t den = poly_eval(dlambda, errs, xinv);
+        if (den == 0) {
+            return -1;
+        }
+        uint8_t num = gf_mul(s_exp[power], poly_eval(omega, parity, xinv));
+        pos[found] = (uint8_t)i;
+        mag[found] = gf_div(num, den);
+        found++;
+    }
+
+    if (found != errs) {
+        return -1;
+    }
+
+    for (int k = 0; k < found; k++) {
+        buffer[pos[k]] ^= mag[k];
+    }
+    return found;
+}
@@ -0,0 +1,41 @@
+#ifndef FEC_H
+#define FEC_H
+
+#include <stdint.h>
+
+/* Largest parity supported: 2t parity bytes correct t byte errors */
+#define FEC_MAX_PARITY         16
+
+/*
+ * Parity bytes appended to every frame on the link (0 = FEC off).
+ * Both nodes build this header, so they always agree.
+ */
+#define FEC_LINK_PARITY_BYTES  0
+
+#if FEC_LINK_PARITY_BYTES > FEC_MAX_PARITY || (FEC_LINK_PARITY_BYTES % 2) != 0
+#error "FEC_LINK_PARITY_BYTES must be even and <= FEC_MAX_PARITY"
+#endif
+
+/**
+ * @brief Append Reed-Solomon parity (GF(256), shortened code) to a frame
+ * @param buffer Frame bytes; parity is written right after them
+ * @param length Frame length in bytes
+ * @param parity Parity bytes to append (even, <= FEC_MAX_PARITY)
+ * @return New length (length + parity), 0 if it would exceed 255 bytes
+ */
+uint8_t fec_encode(uint8_t *buffer, uint8_t length, uint8_t parity);
+
+/**
+ * @brief Correct byte errors in place
+ *
+ * The parity stays in the buffer: the frame is the first
+ * (length - parity) bytes, and the caller drops the rest.
+ *
+ * @param buffer Received codeword (frame + parity)
+ * @param length Codeword length in bytes
+ * @param parity Parity bytes the sender appended
+ * @return Number of bytes corrected (0..parity/2), -1 if uncorrectable
+ */
+int fec_decode(uint8_t *buffer, uint8_t length, uint8_t parity);
+
+#endif /* FEC_H */
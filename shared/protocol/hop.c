@@ -0,0 +1,38 @@
+#include "hop.h"
+
+/* splitmix64 finaliser: spreads node and run over the whole state */
+static uint64_t hop_mix(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+uint8_t hop_channel(uint8_t node_id, uint32_t index, uint8_t count)
+{
+    if (count > HOP_MAX_CHANNELS) {
+        count = HOP_MAX_CHANNELS;
+    }
+    if (count <= 1) {
+        return 0;
+    }
+
+    uint8_t order[HOP_MAX_CHANNELS];
+    for (uint8_t i = 0; i < count; i++) {
+        order[i] = i;
+    }
+
+    /* Fisher-Yates shuffle of this run, stopped once `pos` is drawn */
+    uint32_t run   = index / count;
+    uint8_t  pos   = (uint8_t)(index % count);
+    uint64_t state = ((uint64_t)node_id << 32) | run;
+    for (uint8_t i = 0; i <= pos; i++) {
+        state = hop_mix(state);
+        uint8_t j = (uint8_t)(i + state % (uint8_t)(count - i));
+        uint8_t t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+    return order[pos];
+}
@@ -0,0 +1,30 @@
+#ifndef HOP_H
+#define HOP_H
+
+#include <stdint.h>
+
+/*
+ * Per-node frequency hopping sequences. A node's n-th frame goes out on
+ * hop_channel(node_id, n, count); the sequence needs no state beyond the
+ * frame counter, so it survives deep sleep with a single RTC word.
+ */
+
+/* Largest channel plan supported (US915 has 64 125 kHz uplink channels) */
+#define HOP_MAX_CHANNELS  64
+
+/**
+ * @brief Channel of a node's n-th frame
+ *
+ * Every run of `count` frames visits each channel once, in an order
+ * shuffled from node_id and the run number. Nodes use the plan evenly,
+ * and two nodes that collided once are unlikely to collide again on
+ * their next frames.
+ *
+ * @param node_id Sending node
+ * @param index   Frame number, counting from 0
+ * @param count   Channels in the plan (1..HOP_MAX_CHANNELS)
+ * @return Channel 0..count-1
+ */
+uint8_t hop_channel(uint8_t node_id, uint32_t index, uint8_t count);
+
+#endif /* HOP_H */
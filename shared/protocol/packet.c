@@ -2,6 +2,19 @@
 #include "crc16.h"
 #include <string.h>
 
+/* Write the 7-byte payload in wire order, return bytes written */
+static uint8_t packet_put_payload(const lora_packet_t *pkt, uint8_t *buffer)
+{
+    buffer[0] = pkt->node_id;
+    buffer[1] = (pkt->timestamp >> 24) & 0xFF;
+    buffer[2] = (pkt->timestamp >> 16) & 0xFF;
+    buffer[3] = (pkt->timestamp >>  8) & 0xFF;
+    buffer[4] = (pkt->timestamp)       & 0xFF;
+    buffer[5] = pkt->event_type;
+    buffer[6] = pkt->battery_level;
+    return PACKET_PAYLOAD_SIZE;
+}
+
 void packet_build(lora_packet_t *pkt, uint8_t node_id,
                   uint32_t timestamp, uint8_t event_type,
                   uint8_t battery_level)
@@ -11,30 +24,478 @@ void packet_build(lora_packet_t *pkt, uint8_t node_id,
     pkt->event_type    = event_type;
     pkt->battery_level = battery_level;
 
-    /* Serialize payload (7 bytes) before CRC calculation */
-    uint8_t buffer[PACKET_PAYLOAD_SIZE];
+    /* CRC is produced on the wire by packet_encode() */
+    pkt->crc     = 0;
+    pkt->seq     = 0;
+    pkt->has_seq = false;
+}
+
+uint8_t packet_encode(const lora_packet_t *pkt, uint8_t *buffer)
+{
+    uint8_t len = packet_put_payload(pkt, buffer);
+
+    /* CRC over the bytes just written, while they are still hot */
+    uint16_t crc = crc16_final(crc16_update(crc16_init(), buffer, len));
+    buffer[len++] = (crc >> 8) & 0xFF;
+    buffer[len++] = (crc)      & 0xFF;
+
+    return len;
+}
+
+bool packet_validate_raw(const uint8_t *buffer, uint8_t length)
+{
+    if (length != PACKET_SIZE) {
+        return false;
+    }
+
+    uint16_t calculated = crc16_final(crc16_update(crc16_init(), buffer,
+                                                   PACKET_PAYLOAD_SIZE));
+    uint16_t received   = ((uint16_t)buffer[PACKET_PAYLOAD_SIZE] << 8) |
+                          buffer[PACKET_PAYLOAD_SIZE + 1];
+    return (calculated == received);
+}
+
+bool packet_decode(const uint8_t *buffer, uint8_t length, lora_packet_t *pkt)
+{
+    /* Reject corrupted frames before touching the destination struct */
+    if (!packet_validate_raw(buffer, length)) {
+        return false;
+    }
+
+    packet_deserialize(buffer, pkt);
+    return true;
+}
+
+/* LEB128 varint helpers for the aggregated frame */
+static uint8_t varint_put(uint64_t value, uint8_t *out)
+{
+    uint8_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+static uint8_t varint_get(const uint8_t *in, uint8_t avail, uint64_t *value)
+{
+    uint64_t v = 0;
+    for (uint8_t n = 0; n < avail && n < 5; n++) {
+        v |= (uint64_t)(in[n] & 0x7F) << (7 * n);
+        if (!(in[n] & 0x80)) {
+            *value = v;
+            return n + 1;
+        }
+    }
+    return 0;   /* truncated or overlong */
+}
+
+uint8_t packet_aggregate_encode(const lora_packet_t *pkts, uint8_t count,
+                                uint8_t *buffer, uint8_t size)
+{
+    if (count == 0 || count > PACKET_AGG_MAX_EVENTS ||
+        size < PACKET_AGG_HEADER_SIZE + 2) {
+        return 0;
+    }
+
+    uint32_t base     = pkts[0].timestamp;
+    uint16_t base_seq = pkts[0].seq;
+    buffer[0] = PACKET_TYPE_AGGREGATE;
+    buffer[1] = pkts[0].node_id;
+    buffer[2] = count;
+    buffer[3] = (base_seq >> 8) & 0xFF;
+    buffer[4] = (base_seq)      & 0xFF;
+    buffer[5] = (base >> 24) & 0xFF;
+    buffer[6] = (base >> 16) & 0xFF;
+    buffer[7] = (base >>  8) & 0xFF;
+    buffer[8] = (base)       & 0xFF;
+    buffer[9] = pkts[count - 1].battery_level;
+
+    uint8_t  len  = PACKET_AGG_HEADER_SIZE;
+    uint32_t prev = base;
+    for (uint8_t i = 0; i < count; i++) {
+        if (pkts[i].node_id != pkts[0].node_id ||
+            pkts[i].event_type > 0x03 ||
+            pkts[i].seq != (uint16_t)(base_seq + i)) {
+            return 0;
+        }
+        /* Worst case varint is 5 bytes; keep room for the CRC */
+        if (len + 5 + 2 > size) {
+            return 0;
+        }
+
+        uint32_t delta = pkts[i].timestamp - prev;  /* wraps with the clock */
+        prev = pkts[i].timestamp;
+        len += varint_put(((uint64_t)delta << 2) | pkts[i].event_type,
+                          &buffer[len]);
+    }
+
+    uint16_t crc = crc16_final(crc16_update(crc16_init(), buffer, len));
+    buffer[len++] = (crc >> 8) & 0xFF;
+    buffer[len++] = (crc)      & 0xFF;
+
+    return len;
+}
+
+bool packet_is_aggregate(const uint8_t *buffer, uint8_t length)
+{
+    return (length >= PACKET_AGG_HEADER_SIZE + 3) &&
+           (buffer[0] == PACKET_TYPE_AGGREGATE);
+}
+
+uint8_t packet_aggregate_decode(const uint8_t *buffer, uint8_t length,
+                                lora_packet_t *pkts, uint8_t max)
+{
+    if (!packet_is_aggregate(buffer, length)) {
+        return 0;
+    }
+
+    uint8_t  body = length - 2;
+    uint16_t crc  = ((uint16_t)buffer[body] << 8) | buffer[body + 1];
+    if (crc16_final(crc16_update(crc16_init(), buffer, body)) != crc) {
+        return 0;
+    }
+
+    uint8_t count = buffer[2];
+    if (count == 0 || count > max) {
+        return 0;
+    }
+
+    uint16_t seq = ((uint16_t)buffer[3] << 8) | buffer[4];
+    uint32_t ts  = ((uint32_t)buffer[5] << 24) |
+                   ((uint32_t)buffer[6] << 16) |
+                   ((uint32_t)buffer[7] <<  8) |
+                   ((uint32_t)buffer[8]);
+
+    uint8_t pos = PACKET_AGG_HEADER_SIZE;
+    for (uint8_t i = 0; i < count; i++) {
+        uint64_t v;
+        uint8_t  n = varint_get(&buffer[pos], body - pos, &v);
+        if (n == 0) {
+            return 0;
+        }
+        pos += n;
+        ts  += (uint32_t)(v >> 2);
+
+        pkts[i].node_id       = buffer[1];
+        pkts[i].timestamp     = ts;
+        pkts[i].event_type    = (uint8_t)(v & 0x03);
+        pkts[i].battery_level = buffer[9];
+        pkts[i].crc           = crc;
+        pkts[i].seq           = (uint16_t)(seq + i);
+        pkts[i].has_seq       = true;
+    }
+
+    /* Trailing garbage means the count and body disagree */
+    return (pos == body) ? count : 0;
+}
+
+packet_format_t packet_detect_format(const uint8_t *buffer, uint8_t length)
+{
+    /* Legacy frames carry no marker: they are identified by size alone */
+    if (length == PACKET_SIZE) {
+        return PACKET_FORMAT_LEGACY;
+    }
+    if (packet_is_aggregate(buffer, length)) {
+        return PACKET_FORMAT_AGGREGATE;
+    }
+    if (length >= PACKET_V2_MIN_SIZE && buffer[0] == PACKET_VERSION_2) {
+        return PACKET_FORMAT_V2;
+    }
+    if (length == PACKET_ACK_SIZE && buffer[0] == PACKET_TYPE_ACK) {
+        return PACKET_FORMAT_ACK;
+    }
+    if (length == PACKET_ADR_SIZE && buffer[0] == PACKET_TYPE_ADR) {
+        return PACKET_FORMAT_ADR;
+    }
+    if (length >= PACKET_COMPACT_CORE_SIZE && length <= PACKET_COMPACT_MAX_SIZE) {
+        return PACKET_FORMAT_COMPACT;
+    }
+    return PACKET_FORMAT_INVALID;
+}
+
+bool packet_tlv_put(uint8_t *tlv, uint8_t *tlv_len, uint8_t size,
+                    uint8_t type, const uint8_t *value, uint8_t len)
+{
+    if ((uint16_t)*tlv_len + 2 + len > size) {
+        return false;
+    }
+
+    tlv[(*tlv_len)++] = type;
+    tlv[(*tlv_len)++] = len;
+    memcpy(&tlv[*tlv_len], value, len);
+    *tlv_len += len;
+    return true;
+}
+
+/* Walk TLVs in [pos, end); return the value of type, or NULL. With
+ * type 0 it only checks framing and returns the end pointer. */
+static const uint8_t *tlv_walk(const uint8_t *buffer, uint8_t pos, uint8_t end,
+                               uint8_t type, uint8_t *len)
+{
+    while (pos < end) {
+        if (pos + 2 > end || pos + 2 + buffer[pos + 1] > end) {
+            return NULL;
+        }
+        if (type != 0 && buffer[pos] == type) {
+            *len = buffer[pos + 1];
+            return &buffer[pos + 2];
+        }
+        pos += 2 + buffer[pos + 1];
+    }
+    return (type == 0) ? &buffer[end] : NULL;
+}
+
+uint8_t packet_v2_encode(const lora_packet_t *pkt, const uint8_t *tlv,
+                         uint8_t tlv_len, uint8_t *buffer)
+{
+    uint8_t seq_len = pkt->has_seq ? 4 : 0;
+    if (tlv_len + seq_len > PACKET_V2_MAX_TLV_SIZE) {
+        return 0;
+    }
+
+    buffer[0] = PACKET_VERSION_2;
+    buffer[1] = (tlv_len + seq_len > 0) ? PACKET_V2_FLAG_TLV : 0;
+    buffer[2] = PACKET_PAYLOAD_SIZE + tlv_len + seq_len;
+
+    uint8_t len = PACKET_V2_HEADER_SIZE;
+    len += packet_put_payload(pkt, &buffer[len]);
+    if (pkt->has_seq) {
+        buffer[len++] = PACKET_TLV_SEQUENCE;
+        buffer[len++] = 2;
+        buffer[len++] = (pkt->seq >> 8) & 0xFF;
+        buffer[len++] = (pkt->seq)      & 0xFF;
+    }
+    if (tlv_len > 0) {
+        memcpy(&buffer[len], tlv, tlv_len);
+        len += tlv_len;
+    }
+
+    uint16_t crc = crc16_final(crc16_update(crc16_init(), buffer, len));
+    buffer[len++] = (crc >> 8) & 0xFF;
+    buffer[len++] = (crc)      & 0xFF;
+
+    return len;
+}
+
+bool packet_v2_decode(const uint8_t *buffer, uint8_t length, lora_packet_t *pkt)
+{
+    if (length < PACKET_V2_MIN_SIZE || buffer[0] != PACKET_VERSION_2) {
+        return false;
+    }
+
+    uint8_t body = buffer[2];
+    if (body < PACKET_PAYLOAD_SIZE ||
+        (uint16_t)PACKET_V2_HEADER_SIZE + body + 2 != length) {
+        return false;
+    }
+
+    uint8_t  end = PACKET_V2_HEADER_SIZE + body;
+    uint16_t crc = ((uint16_t)buffer[end] << 8) | buffer[end + 1];
+    if (crc16_final(crc16_update(crc16_init(), buffer, end)) != crc) {
+        return false;
+    }
+
+    uint8_t unused;
+    if (tlv_walk(buffer, PACKET_V2_HEADER_SIZE + PACKET_PAYLOAD_SIZE,
+                 end, 0, &unused) == NULL) {
+        return false;
+    }
+
+    const uint8_t *core = &buffer[PACKET_V2_HEADER_SIZE];
+    pkt->node_id       = core[0];
+    pkt->timestamp     = ((uint32_t)core[1] << 24) |
+                         ((uint32_t)core[2] << 16) |
+                         ((uint32_t)core[3] <<  8) |
+                         ((uint32_t)core[4]);
+    pkt->event_type    = core[5];
+    pkt->battery_level = core[6];
+    pkt->crc           = crc;
+
+    uint8_t vlen = 0;
+    const uint8_t *seq = packet_v2_find_tlv(buffer, length,
+                                            PACKET_TLV_SEQUENCE, &vlen);
+    pkt->has_seq = (seq != NULL && vlen == 2);
+    pkt->seq     = pkt->has_seq ? (((uint16_t)seq[0] << 8) | seq[1]) : 0;
+    return true;
+}
+
+const uint8_t *packet_v2_find_tlv(const uint8_t *buffer, uint8_t length,
+                                  uint8_t type, uint8_t *len)
+{
+    if (type == 0 || length < PACKET_V2_MIN_SIZE) {
+        return NULL;
+    }
+    return tlv_walk(buffer, PACKET_V2_HEADER_SIZE + PACKET_PAYLOAD_SIZE,
+                    length - 2, type, len);
+}
+
+uint8_t packet_compact_encode(const lora_packet_t *pkt, uint8_t crc_bytes,
+                              uint8_t *buffer)
+{
+    if (crc_bytes > 2 || pkt->event_type > 0x03 || pkt->battery_level > 100) {
+        return 0;
+    }
+
+    uint32_t ticks = (pkt->timestamp / PACKET_COMPACT_TS_RES_MS) & 0x7FFFFF;
+    uint32_t word  = ((uint32_t)pkt->event_type    << 30) |
+                     ((uint32_t)pkt->battery_level << 23) |
+                     ticks;
+
     buffer[0] = pkt->node_id;
-    buffer[1] = (pkt->timestamp >> 24) & 0xFF;
-    buffer[2] = (pkt->timestamp >> 16) & 0xFF;
-    buffer[3] = (pkt->timestamp >>  8) & 0xFF;
-    buffer[4] = (pkt->timestamp)       & 0xFF;
-    buffer[5] = pkt->event_type;
-    buffer[6] = pkt->battery_level;
+    buffer[1] = (word >> 24) & 0xFF;
+    buffer[2] = (word >> 16) & 0xFF;
+    buffer[3] = (word >>  8) & 0xFF;
+    buffer[4] = (word)       & 0xFF;
+
+    uint8_t  len = PACKET_COMPACT_CORE_SIZE;
+    uint16_t crc = crc16_final(crc16_update(crc16_init(), buffer, len));
+    if (crc_bytes == 2) {
+        buffer[len++] = (crc >> 8) & 0xFF;
+        buffer[len++] = (crc)      & 0xFF;
+    } else if (crc_bytes == 1) {
+        buffer[len++] = (uint8_t)((crc >> 8) ^ crc);
+    }
 
-    pkt->crc = crc16_calculate(buffer, PACKET_PAYLOAD_SIZE);
+    return len;
+}
+
+bool packet_compact_decode(const uint8_t *buffer, uint8_t length,
+                           lora_packet_t *pkt)
+{
+    if (length < PACKET_COMPACT_CORE_SIZE || length > PACKET_COMPACT_MAX_SIZE) {
+        return false;
+    }
+
+    uint16_t crc = crc16_final(crc16_update(crc16_init(), buffer,
+                                            PACKET_COMPACT_CORE_SIZE));
+    const uint8_t *tail = &buffer[PACKET_COMPACT_CORE_SIZE];
+    if (length == PACKET_COMPACT_CORE_SIZE + 2) {
+        if (tail[0] != (uint8_t)(crc >> 8) || tail[1] != (uint8_t)crc) {
+            return false;
+        }
+    } else if (length == PACKET_COMPACT_CORE_SIZE + 1) {
+        if (tail[0] != (uint8_t)((crc >> 8) ^ crc)) {
+            return false;
+        }
+    }
+
+    uint32_t word = ((uint32_t)buffer[1] << 24) |
+                    ((uint32_t)buffer[2] << 16) |
+                    ((uint32_t)buffer[3] <<  8) |
+                    ((uint32_t)buffer[4]);
+    uint8_t battery = (word >> 23) & 0x7F;
+    if (battery > 100) {
+        return false;
+    }
+
+    pkt->node_id       = buffer[0];
+    pkt->event_type    = (word >> 30) & 0x03;
+    pkt->battery_level = battery;
+    pkt->timestamp     = (word & 0x7FFFFF) * PACKET_COMPACT_TS_RES_MS;
+    pkt->crc           = crc;
+    pkt->seq           = 0;
+    pkt->has_seq       = false;
+    return true;
+}
+
+uint8_t packet_ack_encode(const packet_ack_t *ack, uint8_t *buffer)
+{
+    buffer[0] = PACKET_TYPE_ACK;
+    buffer[1] = ack->node_id;
+    buffer[2] = (ack->ack_seq >> 8) & 0xFF;
+    buffer[3] = (ack->ack_seq)      & 0xFF;
+    buffer[4] = (ack->bitmap >> 24) & 0xFF;
+    buffer[5] = (ack->bitmap >> 16) & 0xFF;
+    buffer[6] = (ack->bitmap >>  8) & 0xFF;
+    buffer[7] = (ack->bitmap)       & 0xFF;
+
+    uint16_t crc = crc16_final(crc16_update(crc16_init(), buffer, 8));
+    buffer[8] = (crc >> 8) & 0xFF;
+    buffer[9] = (crc)      & 0xFF;
+
+    return PACKET_ACK_SIZE;
+}
+
+bool packet_ack_decode(const uint8_t *buffer, uint8_t length, packet_ack_t *ack)
+{
+    if (length != PACKET_ACK_SIZE || buffer[0] != PACKET_TYPE_ACK) {
+        return false;
+    }
+
+    uint16_t crc = ((uint16_t)buffer[8] << 8) | buffer[9];
+    if (crc16_final(crc16_update(crc16_init(), buffer, 8)) != crc) {
+        return false;
+    }
+
+    ack->node_id = buffer[1];
+    ack->ack_seq = ((uint16_t)buffer[2] << 8) | buffer[3];
+    ack->bitmap  = ((uint32_t)buffer[4] << 24) |
+                   ((uint32_t)buffer[5] << 16) |
+                   ((uint32_t)buffer[6] <<  8) |
+                   ((uint32_t)buffer[7]);
+    return true;
+}
+
+bool packet_ack_covers(const packet_ack_t *ack, uint16_t seq)
+{
+    uint16_t back = (uint16_t)(ack->ack_seq - seq);
+    return (back < 32) && (ack->bitmap & (1UL << back));
+}
+
+uint8_t packet_adr_encode(const packet_adr_t *adr, uint8_t *buffer)
+{
+    buffer[0] = PACKET_TYPE_ADR;
+    buffer[1] = adr->node_id;
+    buffer[2] = adr->sf;
+    buffer[3] = (uint8_t)adr->tx_power_dbm;
+    buffer[4] = (uint8_t)adr->margin_db;
+    buffer[5] = 0x00;   /* flags, reserved */
+
+    uint16_t crc = crc16_final(crc16_update(crc16_init(), buffer, 6));
+    buffer[6] = (crc >> 8) & 0xFF;
+    buffer[7] = (crc)      & 0xFF;
+
+    return PACKET_ADR_SIZE;
+}
+
+bool packet_adr_decode(const uint8_t *buffer, uint8_t length, packet_adr_t *adr)
+{
+    if (length != PACKET_ADR_SIZE || buffer[0] != PACKET_TYPE_ADR) {
+        return false;
+    }
+
+    uint16_t crc = ((uint16_t)buffer[6] << 8) | buffer[7];
+    if (crc16_final(crc16_update(crc16_init(), buffer, 6)) != crc) {
+        return false;
+    }
+
+    adr->node_id      = buffer[1];
+    adr->sf           = buffer[2];
+    adr->tx_power_dbm = (int8_t)buffer[3];
+    adr->margin_db    = (int8_t)buffer[4];
+    return true;
+}
+
+bool packet_decode_any(const uint8_t *buffer, uint8_t length, lora_packet_t *pkt)
+{
+    switch (packet_detect_format(buffer, length)) {
+    case PACKET_FORMAT_LEGACY:
+        return packet_decode(buffer, length, pkt);
+    case PACKET_FORMAT_V2:
+        return packet_v2_decode(buffer, length, pkt);
+    case PACKET_FORMAT_COMPACT:
+        return packet_compact_decode(buffer, length, pkt);
+    default:
+        return false;
+    }
 }
 
 void packet_serialize(const lora_packet_t *pkt, uint8_t *buffer)
 {
-    buffer[0] = pkt->node_id;
-    buffer[1] = (pkt->timestamp >> 24) & 0xFF;
-    buffer[2] = (pkt->timestamp >> 16) & 0xFF;
-    buffer[3] = (pkt->timestamp >>  8) & 0xFF;
-    buffer[4] = (pkt->timestamp)       & 0xFF;
-    buffer[5] = pkt->event_type;
-    buffer[6] = pkt->battery_level;
-    buffer[7] = (pkt->crc >> 8) & 0xFF;
-    buffer[8] = (pkt->crc)      & 0xFF;
+    /* packet_build() leaves pkt->crc unset: always compute it here */
+    packet_encode(pkt, buffer);
 }
 
 void packet_deserialize(const uint8_t *buffer, lora_packet_t *pkt)
@@ -47,20 +508,16 @@ void packet_deserialize(const uint8_t *buffer, lora_packet_t *pkt)
     pkt->event_type    = buffer[5];
     pkt->battery_level = buffer[6];
     pkt->crc           = ((uint16_t)buffer[7] << 8) | buffer[8];
+    pkt->seq           = 0;
+    pkt->has_seq       = false;
 }
 
 bool packet_validate(const lora_packet_t *pkt)
 {
     uint8_t buffer[PACKET_PAYLOAD_SIZE];
-    buffer[0] = pkt->node_id;
-    buffer[1] = (pkt->timestamp >> 24) & 0xFF;
-    buffer[2] = (pkt->timestamp >> 16) & 0xFF;
-    buffer[3] = (pkt->timestamp >>  8) & 0xFF;
-    buffer[4] = (pkt->timestamp)       & 0xFF;
-    buffer[5] = pkt->event_type;
-    buffer[6] = pkt->battery_level;
+    packet_put_payload(pkt, buffer);
 
     /* Recalculate and compare against received CRC */
     uint16_t calculated = crc16_calculate(buffer, PACKET_PAYLOAD_SIZE);
     return (calculated == pkt->crc);
-}
\ No newline at end of file
+}
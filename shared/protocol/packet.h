@@ -13,6 +13,104 @@
 /* Payload size without CRC */
 #define PACKET_PAYLOAD_SIZE  7
 
+/* Wire size: payload + CRC16 */
+#define PACKET_SIZE          (PACKET_PAYLOAD_SIZE + 2)
+
+/*
+ * Aggregated frame: N events from one node in a single LoRa frame
+ *
+ *  | 0xA1 | node_id | count | base seq (2B) | base timestamp (4B) | battery |
+ *  | varint(delta0 << 2 | event0) ... varint(deltaN-1 << 2 | eventN-1) | crc16 (2B) |
+ *
+ * delta is the ms gap to the previous event (delta0 = 0), event is the
+ * 2-bit event type, battery is the level of the newest event. Events
+ * carry consecutive sequence numbers starting at base seq.
+ */
+#define PACKET_TYPE_AGGREGATE     0xA1
+#define PACKET_AGG_HEADER_SIZE    10
+#define PACKET_AGG_MAX_EVENTS     16
+#define PACKET_AGG_MAX_SIZE       (PACKET_AGG_HEADER_SIZE + \
+                                   PACKET_AGG_MAX_EVENTS * 5 + 2)
+
+/*
+ * Versioned frame (v2): fixed header, core fields, optional TLVs
+ *
+ *  | 0x02 | flags | len | node_id | timestamp (4B) | event_type | battery |
+ *  | TLV: type, length, value ... | crc16 (2B) |
+ *
+ * len counts the bytes between the header and the CRC. Receivers skip
+ * TLV types and flag bits they do not know, so new optional fields can
+ * be added without a flag day. Legacy 9-byte frames stay valid.
+ */
+#define PACKET_VERSION_2          0x02
+#define PACKET_V2_HEADER_SIZE     3
+#define PACKET_V2_MAX_TLV_SIZE    64
+#define PACKET_V2_MIN_SIZE        (PACKET_V2_HEADER_SIZE + PACKET_PAYLOAD_SIZE + 2)
+#define PACKET_V2_MAX_SIZE        (PACKET_V2_MIN_SIZE + PACKET_V2_MAX_TLV_SIZE)
+
+/* v2 flags */
+#define PACKET_V2_FLAG_TLV        0x01   /* Optional fields present */
+
+/* v2 TLV types */
+#define PACKET_TLV_BATTERY_MV     0x01   /* uint16 battery voltage (mV) */
+#define PACKET_TLV_SEQUENCE       0x02   /* uint16 per-node sequence    */
+
+/*
+ * Compact frame: bit-packed single event, 5-7 bytes
+ *
+ *  | node_id | event(2b) battery(7b) ticks(23b) (4B) | crc (0-2B) |
+ *
+ * ticks = timestamp / PACKET_COMPACT_TS_RES_MS (wraps). The CRC may be
+ * truncated to one byte or dropped when the radio CRC is on; the
+ * receiver tells the CRC size from the frame length. A build may set
+ * the resolution; both nodes must use the same one.
+ */
+#ifndef PACKET_COMPACT_TS_RES_MS
+#define PACKET_COMPACT_TS_RES_MS  1000
+#endif
+#if PACKET_COMPACT_TS_RES_MS < 1
+#error "PACKET_COMPACT_TS_RES_MS must be at least 1"
+#endif
+#define PACKET_COMPACT_CORE_SIZE  5
+#define PACKET_COMPACT_MAX_SIZE   (PACKET_COMPACT_CORE_SIZE + 2)
+
+/*
+ * ACK frame (receiver -> transmitter, ARQ mode)
+ *
+ *  | 0xAC | node_id | ack seq (2B) | bitmap (4B) | crc16 (2B) |
+ *
+ * ack seq is the highest sequence number received from node_id; bit i
+ * of bitmap is set when (ack seq - i) was received.
+ */
+#define PACKET_TYPE_ACK           0xAC
+#define PACKET_ACK_SIZE           10
+
+/*
+ * ADR command (receiver -> transmitter, adaptive data rate)
+ *
+ *  | 0xAD | node_id | sf | tx power (dBm) | margin (dB) | flags | crc16 (2B) |
+ *
+ * Power and margin are signed. margin is the link margin the receiver
+ * measured at the node's previous setting (informational). flags is
+ * reserved, 0.
+ */
+#define PACKET_TYPE_ADR           0xAD
+#define PACKET_ADR_SIZE           8
+
+/* Largest frame a receiver must be ready to read (LoRa limit) */
+#define PACKET_MAX_FRAME_SIZE     255
+
+/* Wire format detected from raw bytes */
+typedef enum {
+    PACKET_FORMAT_INVALID = 0,
+    PACKET_FORMAT_LEGACY,      /* 9-byte v1 frame   */
+    PACKET_FORMAT_AGGREGATE,   /* 0xA1 multi-event  */
+    PACKET_FORMAT_V2,          /* 0x02 versioned    */
+    PACKET_FORMAT_COMPACT,     /* 5-7 byte packed   */
+    PACKET_FORMAT_ACK,         /* 0xAC ARQ ack      */
+    PACKET_FORMAT_ADR,         /* 0xAD ADR command  */
+} packet_format_t;
+
 /**
  * @brief LoRa packet structure (9 bytes total)
  *
@@ -24,17 +122,202 @@ typedef struct {
     uint8_t  event_type;     /* Event type (see defines above)*/
     uint8_t  battery_level;  /* Battery level 0-100 %         */
     uint16_t crc;            /* CRC16-CCITT of payload        */
+    uint16_t seq;            /* Per-node sequence number      */
+    bool     has_seq;        /* seq is valid (v2 / aggregate) */
 } lora_packet_t;
 
 /**
- * @brief Build a packet and calculate its CRC
+ * @brief Selective acknowledgement carried by an ACK frame
+ */
+typedef struct {
+    uint8_t  node_id;        /* Transmitter being acknowledged */
+    uint16_t ack_seq;        /* Highest sequence received      */
+    uint32_t bitmap;         /* Bit i = (ack_seq - i) received */
+} packet_ack_t;
+
+/**
+ * @brief Data rate / power assignment carried by an ADR frame
+ */
+typedef struct {
+    uint8_t node_id;         /* Transmitter being commanded    */
+    uint8_t sf;              /* Spreading factor to use        */
+    int8_t  tx_power_dbm;    /* TX power to use                */
+    int8_t  margin_db;       /* Margin measured before change  */
+} packet_adr_t;
+
+/**
+ * @brief Fill packet fields (pkt->crc is left 0; packet_encode() and
+ *        packet_serialize() compute the CRC on the wire)
  */
 void packet_build(lora_packet_t *pkt, uint8_t node_id,
                   uint32_t timestamp, uint8_t event_type,
                   uint8_t battery_level);
 
 /**
- * @brief Serialize packet to bytes for LoRa transmission
+ * @brief Encode packet straight into the wire buffer, computing the CRC
+ *        in the same pass (pkt->crc is ignored)
+ * @param pkt    Source packet
+ * @param buffer Destination buffer (minimum PACKET_SIZE bytes)
+ * @return Number of bytes written
+ */
+uint8_t packet_encode(const lora_packet_t *pkt, uint8_t *buffer);
+
+/**
+ * @brief Check length and CRC directly on received raw bytes
+ * @param buffer Received bytes
+ * @param length Number of bytes received
+ * @return true if the frame is intact
+ */
+bool packet_validate_raw(const uint8_t *buffer, uint8_t length);
+
+/**
+ * @brief Validate raw bytes, then deserialize them into a packet
+ * @param buffer Received bytes
+ * @param length Number of bytes received
+ * @param pkt    Destination structure (untouched on failure)
+ * @return true if the frame was valid and decoded
+ */
+bool packet_decode(const uint8_t *buffer, uint8_t length, lora_packet_t *pkt);
+
+/**
+ * @brief Encode up to PACKET_AGG_MAX_EVENTS packets from one node into an
+ *        aggregated frame (timestamps in send order, consecutive seq)
+ * @param pkts   Source packets, oldest first
+ * @param count  Number of packets (1..PACKET_AGG_MAX_EVENTS)
+ * @param buffer Destination buffer
+ * @param size   Destination buffer size
+ * @return Number of bytes written, 0 if the batch cannot be aggregated
+ */
+uint8_t packet_aggregate_encode(const lora_packet_t *pkts, uint8_t count,
+                                uint8_t *buffer, uint8_t size);
+
+/**
+ * @brief Check whether raw bytes carry an aggregated frame
+ */
+bool packet_is_aggregate(const uint8_t *buffer, uint8_t length);
+
+/**
+ * @brief Validate an aggregated frame and unpack it into individual packets
+ * @param buffer Received bytes
+ * @param length Number of bytes received
+ * @param pkts   Destination array
+ * @param max    Capacity of the destination array
+ * @return Number of packets unpacked, 0 if the frame is invalid
+ */
+uint8_t packet_aggregate_decode(const uint8_t *buffer, uint8_t length,
+                                lora_packet_t *pkts, uint8_t max);
+
+/**
+ * @brief Classify raw bytes by wire format (header only, no CRC check)
+ * @param buffer Received bytes
+ * @param length Number of bytes received
+ * @return Detected format, PACKET_FORMAT_INVALID if none matches
+ */
+packet_format_t packet_detect_format(const uint8_t *buffer, uint8_t length);
+
+/**
+ * @brief Append a TLV to an optional-field buffer
+ * @param tlv      TLV buffer
+ * @param tlv_len  Current TLV buffer length (updated on success)
+ * @param size     TLV buffer capacity
+ * @param type     TLV type (PACKET_TLV_*)
+ * @param value    Value bytes
+ * @param len      Value length
+ * @return true if the TLV fit
+ */
+bool packet_tlv_put(uint8_t *tlv, uint8_t *tlv_len, uint8_t size,
+                    uint8_t type, const uint8_t *value, uint8_t len);
+
+/**
+ * @brief Encode a v2 frame with optional TLVs, CRC computed in the same pass
+ *
+ * A PACKET_TLV_SEQUENCE field is added automatically when pkt->has_seq.
+ *
+ * @param pkt     Core fields
+ * @param tlv     TLV bytes built with packet_tlv_put() (may be NULL)
+ * @param tlv_len TLV byte count (0..PACKET_V2_MAX_TLV_SIZE)
+ * @param buffer  Destination buffer (minimum PACKET_V2_MIN_SIZE + tlv_len)
+ * @return Number of bytes written, 0 on error
+ */
+uint8_t packet_v2_encode(const lora_packet_t *pkt, const uint8_t *tlv,
+                         uint8_t tlv_len, uint8_t *buffer);
+
+/**
+ * @brief Validate a v2 frame (length, CRC, TLV framing) and decode core fields
+ * @return true if the frame was valid and decoded
+ */
+bool packet_v2_decode(const uint8_t *buffer, uint8_t length, lora_packet_t *pkt);
+
+/**
+ * @brief Find an optional field in a validated v2 frame
+ * @param buffer Received bytes (already accepted by packet_v2_decode)
+ * @param length Number of bytes received
+ * @param type   TLV type to look for
+ * @param len    Out: value length
+ * @return Pointer to the value inside buffer, NULL if absent
+ */
+const uint8_t *packet_v2_find_tlv(const uint8_t *buffer, uint8_t length,
+                                  uint8_t type, uint8_t *len);
+
+/**
+ * @brief Encode packet as a bit-packed compact frame
+ * @param pkt       Source packet (event_type 0-3, battery 0-100)
+ * @param crc_bytes CRC bytes to append: 2, 1 (folded) or 0 (radio CRC only)
+ * @param buffer    Destination buffer (minimum PACKET_COMPACT_MAX_SIZE)
+ * @return Number of bytes written, 0 if the packet does not fit the format
+ */
+uint8_t packet_compact_encode(const lora_packet_t *pkt, uint8_t crc_bytes,
+                              uint8_t *buffer);
+
+/**
+ * @brief Validate and unpack a compact frame (timestamp is coarse)
+ * @return true if the frame was valid and decoded
+ */
+bool packet_compact_decode(const uint8_t *buffer, uint8_t length,
+                           lora_packet_t *pkt);
+
+/**
+ * @brief Encode an ACK frame
+ * @param ack    Acknowledgement to send
+ * @param buffer Destination buffer (minimum PACKET_ACK_SIZE)
+ * @return Number of bytes written
+ */
+uint8_t packet_ack_encode(const packet_ack_t *ack, uint8_t *buffer);
+
+/**
+ * @brief Validate and decode an ACK frame
+ * @return true if the frame was a valid ACK
+ */
+bool packet_ack_decode(const uint8_t *buffer, uint8_t length, packet_ack_t *ack);
+
+/**
+ * @brief Check whether an ACK covers a given sequence number
+ */
+bool packet_ack_covers(const packet_ack_t *ack, uint16_t seq);
+
+/**
+ * @brief Encode an ADR command frame
+ * @param adr    Command to send
+ * @param buffer Destination (minimum PACKET_ADR_SIZE bytes)
+ * @return Number of bytes written
+ */
+uint8_t packet_adr_encode(const packet_adr_t *adr, uint8_t *buffer);
+
+/**
+ * @brief Validate and decode an ADR command frame
+ * @return true if the frame is an intact ADR command
+ */
+bool packet_adr_decode(const uint8_t *buffer, uint8_t length, packet_adr_t *adr);
+
+/**
+ * @brief Decode a single-event frame in legacy, v2 or compact format
+ * @return true if the frame was valid and decoded
+ */
+bool packet_decode_any(const uint8_t *buffer, uint8_t length, lora_packet_t *pkt);
+
+/**
+ * @brief Serialize packet to bytes with a freshly computed CRC
+ *        (same as packet_encode(); pkt->crc is ignored)
  * @param pkt    Source packet
  * @param buffer Destination buffer (minimum 9 bytes)
  */
@@ -0,0 +1,93 @@
+#include "seq_tracker.h"
+#include <string.h>
+
+void seq_tracker_init(seq_tracker_t *t)
+{
+    memset(t, 0, sizeof(*t));
+}
+
+/* Start a fresh window at seq, keeping the cumulative counters */
+static void seq_tracker_restart(seq_tracker_t *t, uint16_t seq)
+{
+    t->active   = true;
+    t->highest  = seq;
+    t->window   = 1;
+    t->expected++;
+    t->received++;
+}
+
+seq_result_t seq_tracker_update(seq_tracker_t *t, uint16_t seq)
+{
+    if (!t->active) {
+        seq_tracker_restart(t, seq);
+        return SEQ_RESULT_NEW;
+    }
+
+    int16_t diff = (int16_t)(seq - t->highest);
+
+    if (diff > 0) {
+        t->window  = (diff < SEQ_WINDOW_SIZE) ? (t->window << diff) | 1 : 1;
+        t->highest = seq;
+        t->received++;
+
+        /* Up to a block ahead onto a block boundary: a restarted
+         * seq_sender_t resuming from its stored limit, nothing was sent */
+        if (diff > 1 && diff <= SEQ_SENDER_BLOCK && (seq % SEQ_SENDER_BLOCK) == 0) {
+            t->expected++;
+            t->resets++;
+            return SEQ_RESULT_RESET;
+        }
+
+        /* Ahead: everything skipped over counts as lost until it shows up */
+        t->expected += (uint32_t)diff;
+        t->lost     += (uint32_t)diff - 1;
+        return SEQ_RESULT_NEW;
+    }
+
+    uint16_t back = (uint16_t)(-diff);
+    if (back >= SEQ_WINDOW_SIZE) {
+        /* Too old for the window: the sender rebooted and restarted */
+        t->resets++;
+        seq_tracker_restart(t, seq);
+        return SEQ_RESULT_RESET;
+    }
+
+    uint32_t bit = 1UL << back;
+    if (t->window & bit) {
+        t->duplicates++;
+        return SEQ_RESULT_DUPLICATE;
+    }
+
+    /* Late arrival fills a hole that was counted as lost */
+    t->window |= bit;
+    t->received++;
+    t->reordered++;
+    if (t->lost > 0) {
+        t->lost--;
+    }
+    return SEQ_RESULT_REORDERED;
+}
+
+uint32_t seq_tracker_loss_permille(const seq_tracker_t *t)
+{
+    if (t->expected == 0) {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)t->lost * 1000) / t->expected);
+}
+
+void seq_sender_resume(seq_sender_t *s, uint16_t stored_limit)
+{
+    s->next  = stored_limit;
+    s->limit = stored_limit;
+}
+
+bool seq_sender_next(seq_sender_t *s, uint16_t *seq)
+{
+    bool reserve = (s->next == s->limit);
+    if (reserve) {
+        s->limit = (uint16_t)(s->limit + SEQ_SENDER_BLOCK);
+    }
+    *seq = s->next++;
+    return reserve;
+}
@@ -0,0 +1,92 @@
+#ifndef SEQ_TRACKER_H
+#define SEQ_TRACKER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Sliding window width: late frames up to this far back are accepted */
+#define SEQ_WINDOW_SIZE   32
+
+/* Sender side: sequence numbers reserved in storage per write */
+#define SEQ_SENDER_BLOCK  64
+
+/* Classification of one received sequence number */
+typedef enum {
+    SEQ_RESULT_NEW = 0,     /* In order (possibly after a gap)        */
+    SEQ_RESULT_REORDERED,   /* Late, but not seen before              */
+    SEQ_RESULT_DUPLICATE,   /* Already seen - drop it                 */
+    SEQ_RESULT_RESET,       /* Sender restarted: far behind the window,
+                             * or resumed at its next block            */
+} seq_result_t;
+
+/**
+ * @brief Per-node sequence window and loss counters (no heap, O(1) update)
+ */
+typedef struct {
+    bool     active;        /* First frame seen                        */
+    uint16_t highest;       /* Highest sequence number seen            */
+    uint32_t window;        /* Bit i set = (highest - i) was received  */
+    uint32_t expected;      /* Span of sequence numbers since start    */
+    uint32_t received;      /* Unique frames received                  */
+    uint32_t lost;          /* Frames missing (late arrivals refund)   */
+    uint32_t duplicates;    /* Frames dropped as duplicates            */
+    uint32_t reordered;     /* Frames that arrived late                */
+    uint32_t resets;        /* Sender restarts detected                */
+} seq_tracker_t;
+
+/**
+ * @brief Reset a tracker to its initial state
+ */
+void seq_tracker_init(seq_tracker_t *t);
+
+/**
+ * @brief Account for one received sequence number
+ *
+ * A jump of 2..SEQ_SENDER_BLOCK onto a multiple of SEQ_SENDER_BLOCK is
+ * where a restarted seq_sender_t resumes. It counts as a restart, not
+ * as lost frames; real loss ending just before a block boundary is
+ * undercounted the same way.
+ *
+ * @param t   Tracker for the sending node
+ * @param seq Sequence number from the frame
+ * @return Classification; SEQ_RESULT_DUPLICATE frames should be dropped
+ */
+seq_result_t seq_tracker_update(seq_tracker_t *t, uint16_t seq);
+
+/**
+ * @brief Loss rate since the tracker started
+ * @return Lost frames per thousand expected
+ */
+uint32_t seq_tracker_loss_permille(const seq_tracker_t *t);
+
+/**
+ * @brief Sender's sequence counter that never repeats across restarts
+ *
+ * A restarted sender that counts from 0 again would land inside the
+ * receiver's window, and its new frames would be dropped as duplicates.
+ * The sender instead stores a limit ahead of the numbers it has used,
+ * SEQ_SENDER_BLOCK at a time, and resumes from that limit. A restart
+ * then looks like a forward gap of at most SEQ_SENDER_BLOCK frames onto
+ * a block boundary, which the tracker takes as a restart.
+ */
+typedef struct {
+    uint16_t next;          /* Next sequence number to send            */
+    uint16_t limit;         /* First number not yet reserved in storage */
+} seq_sender_t;
+
+/**
+ * @brief Resume after a restart from the limit last stored
+ * @param s            Counter
+ * @param stored_limit Limit from storage, 0 if none was ever saved
+ */
+void seq_sender_resume(seq_sender_t *s, uint16_t stored_limit);
+
+/**
+ * @brief Take the next sequence number
+ * @param s   Counter
+ * @param seq Number to send
+ * @return true if s->limit moved: store it before sending the frame
+ */
+bool seq_sender_next(seq_sender_t *s, uint16_t *seq);
+
+#endif /* SEQ_TRACKER_H */
@@ -0,0 +1,259 @@
+/**
+ * Adaptive data rate simulation: energy per delivered packet
+ *
+ * Nodes at 200 m .. 6 km from the receiver, log-distance path loss with
+ * per-node shadowing and per-frame fading. A frame is delivered when
+ * its SNR and RSSI clear the SX1262 floor for its SF (adr.c tables).
+ * Compares fixed settings against ADR driven by the same adr_link_*()
+ * code the receiver runs, including lost commands, the transmitter's
+ * revert after ADR_ACK_LIMIT silent frames and the receiver fallback.
+ *
+ * Each node is simulated as its own point-to-point link (the receiver
+ * follows that node's SF), which is what ADR_ADAPT_SF supports.
+ *
+ * Build:
+ *   gcc -O2 -I shared/protocol tools/adr_sim.c shared/protocol/adr.c \
+ *       shared/protocol/airtime.c shared/protocol/packet.c \
+ *       shared/protocol/crc16.c -lm -o adr_sim
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "adr.h"
+#include "airtime.h"
+#include "packet.h"
+
+#define SIM_NODES            40
+#define SIM_FRAMES           2000
+#define SIM_INTERVAL_MS      60000    /* One uplink per minute           */
+#define SIM_DIST_MIN_M       200.0
+#define SIM_DIST_MAX_M       6000.0
+
+/* Suburban 868 MHz link: 40 dB at 1 m, exponent 2.9 */
+#define SIM_PL_1M_DB         40.0
+#define SIM_PL_EXPONENT      2.9
+#define SIM_SHADOW_SIGMA_DB  6.0      /* Per node, fixed                 */
+#define SIM_FADE_SIGMA_DB    3.0      /* Per frame                       */
+#define SIM_NOISE_DBM        -117.0   /* -174 + 10log10(125k) + NF 6     */
+#define SIM_SNR_REPORT_MAX   10.0     /* SX1262 SNR estimate saturates   */
+
+#define SIM_SUPPLY_V         3.3
+#define SIM_RX_MA            4.6
+#define SIM_RX_POWER_DBM     20       /* Receiver's command TX power     */
+
+/* Rough SX1262 TX current with the +22 dBm PA configuration */
+static const struct { int dbm; double ma; } s_tx_current[] = {
+    { 2, 28.0 }, { 5, 32.0 }, { 10, 45.0 }, { 14, 60.0 },
+    { 17, 90.0 }, { 20, 100.0 }, { 22, 118.0 },
+};
+
+typedef struct {
+    const char *name;
+    bool        adr;
+    uint8_t     sf;
+    int8_t      power;
+} strategy_t;
+
+typedef struct {
+    uint32_t sent;
+    uint32_t delivered;
+    double   energy_mj;
+    double   sf_sum;
+    double   power_sum;
+} totals_t;
+
+/* ─── Helpers ────────────────────────────────────────────────── */
+
+static uint64_t s_rng = 0x2545F4914F6CDD1DULL;
+
+static double uniform(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 7;
+    s_rng ^= s_rng << 17;
+    return ((s_rng >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static double gaussian(double sigma)
+{
+    return sigma * sqrt(-2.0 * log(uniform())) * cos(2.0 * M_PI * uniform());
+}
+
+static double tx_current_ma(int dbm)
+{
+    const int n = sizeof(s_tx_current) / sizeof(s_tx_current[0]);
+    if (dbm <= s_tx_current[0].dbm) {
+        return s_tx_current[0].ma;
+    }
+    for (int i = 1; i < n; i++) {
+        if (dbm <= s_tx_current[i].dbm) {
+            double f = (double)(dbm - s_tx_current[i - 1].dbm) /
+                       (s_tx_current[i].dbm - s_tx_current[i - 1].dbm);
+            return s_tx_current[i - 1].ma + f * (s_tx_current[i].ma - s_tx_current[i - 1].ma);
+        }
+    }
+    return s_tx_current[n - 1].ma;
+}
+
+static double airtime_ms(uint8_t sf, uint8_t length)
+{
+    airtime_params_t p = {
+        .sf = sf, .bw_hz = 125000, .cr = 1, .preamble = 8,
+        .implicit_header = false, .crc_on = true,
+    };
+    return airtime_lora_us(&p, length) / 1000.0;
+}
+
+/* One transmission over the link; fills the receiver's measurements */
+static bool link_frame(double path_loss_db, uint8_t sf, int power_dbm,
+                       int *snr_qdb, int *rssi_dbm)
+{
+    double rssi = power_dbm - path_loss_db + gaussian(SIM_FADE_SIGMA_DB);
+    double snr  = rssi - SIM_NOISE_DBM;
+
+    if (snr * 4.0 < adr_required_snr_qdb(sf) || rssi < adr_sensitivity_dbm(sf)) {
+        return false;
+    }
+    if (snr > SIM_SNR_REPORT_MAX) {
+        snr = SIM_SNR_REPORT_MAX;
+    }
+    *snr_qdb  = (int)lround(snr * 4.0);
+    *rssi_dbm = (int)lround(rssi);
+    return true;
+}
+
+/* ─── One node under one strategy ────────────────────────────── */
+
+static void run_node(const strategy_t *st, double path_loss_db,
+                     uint8_t frame_len, totals_t *t)
+{
+    adr_setting_t base = { st->sf, st->power };
+    adr_setting_t node = base;        /* What the transmitter uses      */
+    adr_link_t    link;               /* Receiver state; current.sf is  */
+    adr_link_init(&link, base);       /* also the receiver's own SF     */
+
+    uint32_t silent = 0;
+    uint32_t quiet_ms = 0;
+
+    for (int f = 0; f < SIM_FRAMES; f++) {
+        double tx_ms = airtime_ms(node.sf, frame_len);
+        t->sent++;
+        t->energy_mj += tx_ms * tx_current_ma(node.tx_power_dbm) * SIM_SUPPLY_V / 1000.0;
+        t->sf_sum    += node.sf;
+        t->power_sum += node.tx_power_dbm;
+
+        int snr, rssi;
+        bool heard = (!st->adr || !ADR_ADAPT_SF || node.sf == link.current.sf) &&
+                     link_frame(path_loss_db, node.sf, node.tx_power_dbm, &snr, &rssi);
+        if (heard) {
+            t->delivered++;
+        }
+        if (!st->adr) {
+            continue;
+        }
+
+        /* Receiver side: measure, decide, maybe command */
+        bool commanded = false;
+        adr_setting_t next;
+        if (heard) {
+            quiet_ms = 0;
+            adr_link_observe(&link, snr, rssi);
+            if (adr_link_decide(&link, &next)) {
+                int dl_snr, dl_rssi;
+                /* Command goes out on the node's current SF */
+                commanded = link_frame(path_loss_db, node.sf, SIM_RX_POWER_DBM,
+                                       &dl_snr, &dl_rssi);
+            }
+        } else {
+            quiet_ms += SIM_INTERVAL_MS;
+            if (ADR_ADAPT_SF && quiet_ms >= ADR_FALLBACK_MS) {
+                adr_link_init(&link, base);
+                quiet_ms = 0;
+            }
+        }
+
+        /* Transmitter side: RX window, closed early by a command */
+        double rx_ms = commanded ? airtime_ms(node.sf, PACKET_ADR_SIZE)
+                                 : ADR_RX_WINDOW_MS;
+        t->energy_mj += rx_ms * SIM_RX_MA * SIM_SUPPLY_V / 1000.0;
+
+        if (commanded) {
+            node   = next;
+            silent = 0;
+        } else if (++silent >= ADR_ACK_LIMIT) {
+            node   = base;
+            silent = 0;
+        }
+    }
+}
+
+/* ─── Main ───────────────────────────────────────────────────── */
+
+int main(void)
+{
+    const strategy_t strategies[] = {
+        { "fixed SF7 +20",   false, 7,  20 },
+        { "fixed SF10 +20",  false, 10, 20 },
+        { "ADR from SF10",   true,  10, 20 },
+    };
+    const int n_strat = sizeof(strategies) / sizeof(strategies[0]);
+
+    lora_packet_t pkt;
+    packet_build(&pkt, 0x01, 123456, EVENT_PIR_MOTION, 87);
+    uint8_t buf[PACKET_MAX_FRAME_SIZE];
+    uint8_t frame_len = packet_v2_encode(&pkt, NULL, 0, buf);
+
+    /* Same node placement for every strategy */
+    double path_loss[SIM_NODES];
+    double distance[SIM_NODES];
+    for (int n = 0; n < SIM_NODES; n++) {
+        distance[n] = SIM_DIST_MIN_M *
+                      pow(SIM_DIST_MAX_M / SIM_DIST_MIN_M, (n + 0.5) / SIM_NODES);
+        path_loss[n] = SIM_PL_1M_DB + 10.0 * SIM_PL_EXPONENT * log10(distance[n]) +
+                       gaussian(SIM_SHADOW_SIGMA_DB);
+    }
+
+    printf("ADR simulation: %d nodes, %.0f m .. %.0f m, %d frames each, "
+           "%uB v2 frame\n", SIM_NODES, SIM_DIST_MIN_M, SIM_DIST_MAX_M,
+           SIM_FRAMES, frame_len);
+    printf("margin %d dB, step %d dB, RX window %d ms, SF adaptation %s\n\n",
+           ADR_MARGIN_DB, ADR_STEP_DB, ADR_RX_WINDOW_MS, ADR_ADAPT_SF ? "on" : "off");
+
+    /* Split near / far half to show where the savings come from */
+    printf("%-16s %10s %12s %10s %10s %14s %14s\n", "strategy", "delivered",
+           "mJ/packet", "mean SF", "mean dBm", "near mJ/pkt", "far mJ/pkt");
+    for (int s = 0; s < n_strat; s++) {
+        totals_t all = {0}, half[2] = {{0}};
+        s_rng = 0x9E3779B97F4A7C15ULL;   /* Same fading sequence per strategy */
+        for (int n = 0; n < SIM_NODES; n++) {
+            totals_t t = {0};
+            run_node(&strategies[s], path_loss[n], frame_len, &t);
+            totals_t *h = &half[n >= SIM_NODES / 2];
+            h->delivered += t.delivered;
+            h->energy_mj += t.energy_mj;
+            all.sent      += t.sent;
+            all.delivered += t.delivered;
+            all.energy_mj += t.energy_mj;
+            all.sf_sum    += t.sf_sum;
+            all.power_sum += t.power_sum;
+        }
+
+        printf("%-16s %9.1f%% %12.3f %10.2f %10.1f", strategies[s].name,
+               100.0 * all.delivered / all.sent,
+               all.delivered ? all.energy_mj / all.delivered : 0.0,
+               all.sf_sum / all.sent, all.power_sum / all.sent);
+        for (int h = 0; h < 2; h++) {
+            if (half[h].delivered) {
+                printf(" %14.3f", half[h].energy_mj / half[h].delivered);
+            } else {
+                printf(" %14s", "-");
+            }
+        }
+        printf("\n");
+    }
+
+    printf("\nnear = closest %d nodes (<= %.0f m), far = the rest\n",
+           SIM_NODES / 2, distance[SIM_NODES / 2 - 1]);
+    return 0;
+}
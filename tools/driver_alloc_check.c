@@ -0,0 +1,101 @@
+/**
+ * Heap allocation counter for the SX1262 driver
+ *
+ * Links a lora_driver.c copy against the host ESP-IDF shim and the
+ * SX1262 simulator, wraps malloc/calloc/realloc/free at link time, and
+ * checks that lora_driver_send() / lora_driver_receive() make zero heap
+ * calls after lora_driver_init(). Also reports SPI transactions and bytes
+ * per operation.
+ *
+ * Build: see tools/CMakeLists.txt (driver_alloc_check_transmitter / _receiver)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lora_driver.h"
+#include "sx1262_sim.h"
+#include "esp_timer.h"
+#include "packet.h"
+
+#define CHECK_ROUNDS  1000
+
+static uint32_t s_heap_calls;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void  __real_free(void *ptr);
+
+void *__wrap_malloc(size_t size)             { s_heap_calls++; return __real_malloc(size); }
+void *__wrap_calloc(size_t n, size_t size)   { s_heap_calls++; return __real_calloc(n, size); }
+void *__wrap_realloc(void *ptr, size_t size) { s_heap_calls++; return __real_realloc(ptr, size); }
+void  __wrap_free(void *ptr)                 { s_heap_calls++; __real_free(ptr); }
+
+static void report(const char *name, uint32_t heap)
+{
+    const sx1262_sim_stats_t *st = sx1262_sim_stats();
+    printf("%-22s heap calls/op %6.2f   SPI trans/op %5.1f   bytes/op %6.1f   bus us/op %6.1f\n",
+           name, (double)heap / CHECK_ROUNDS,
+           (double)st->transactions / CHECK_ROUNDS,
+           (double)st->bytes / CHECK_ROUNDS,
+           st->bus_ns / 1000.0 / CHECK_ROUNDS);
+}
+
+int main(void)
+{
+    if (!lora_driver_init()) {
+        printf("lora_driver_init failed\n");
+        return 1;
+    }
+    printf("init: %u heap calls (allowed)\n", s_heap_calls);
+
+    lora_packet_t pkt;
+    uint8_t frame[PACKET_SIZE];
+    uint8_t echo[256];
+    packet_build(&pkt, 0x01, 123456, EVENT_PIR_MOTION, 87);
+
+    /* Send */
+    s_heap_calls = 0;
+    sx1262_sim_reset_stats();
+    for (uint32_t i = 0; i < CHECK_ROUNDS; i++) {
+        pkt.timestamp = i;
+        uint8_t len = packet_encode(&pkt, frame);
+        if (!lora_driver_send(frame, len) ||
+            sx1262_sim_last_tx(echo) != len || memcmp(echo, frame, len) != 0) {
+            printf("send round %u: frame did not reach the radio\n", i);
+            return 1;
+        }
+    }
+    uint32_t send_heap = s_heap_calls;
+    report("lora_driver_send", send_heap);
+
+    /* Receive */
+    s_heap_calls = 0;
+    sx1262_sim_reset_stats();
+    lora_driver_listen();
+    for (uint32_t i = 0; i < CHECK_ROUNDS; i++) {
+        pkt.timestamp = i;
+        uint8_t len = packet_encode(&pkt, frame);
+        int64_t rx_done_us = esp_timer_get_time();
+        sx1262_sim_inject_rx(frame, len, -87);
+
+        uint8_t buf[LORA_MAX_PACKET_SIZE];
+        lora_rx_meta_t meta;
+        if (!lora_driver_wait_irq(10) || !lora_driver_available() ||
+            lora_driver_receive(buf, sizeof(buf), &meta) != len ||
+            memcmp(buf, frame, len) != 0 || meta.rssi_dbm != -87 ||
+            meta.timestamp_us != rx_done_us) {
+            printf("receive round %u: frame corrupted\n", i);
+            return 1;
+        }
+    }
+    uint32_t recv_heap = s_heap_calls;
+    report("wait+available+receive", recv_heap);
+
+    if (send_heap || recv_heap) {
+        printf("FAIL: driver allocates on the data path\n");
+        return 1;
+    }
+    printf("PASS: zero heap calls per send/receive\n");
+    return 0;
+}
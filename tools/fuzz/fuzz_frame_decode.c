@@ -0,0 +1,70 @@
+/**
+ * libFuzzer harness: every raw-frame decoder a receiver runs on air data
+ *
+ * Feeds arbitrary bytes through format detection, the single-event,
+ * aggregated, ACK and ADR decoders, TLV lookup and the FEC decoder. ASan and
+ * UBSan catch out-of-bounds reads; decoded v2/legacy frames must
+ * re-encode to the same bytes.
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include "packet.h"
+#include "fec.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size == 0 || size > PACKET_MAX_FRAME_SIZE) {
+        return 0;
+    }
+
+    uint8_t length = (uint8_t)size;
+    uint8_t frame[PACKET_MAX_FRAME_SIZE];
+    memcpy(frame, data, length);
+
+    lora_packet_t pkt;
+    lora_packet_t events[PACKET_AGG_MAX_EVENTS];
+    packet_ack_t  ack;
+    packet_adr_t  adr;
+    uint8_t       tlv_len;
+    uint8_t       out[PACKET_MAX_FRAME_SIZE];
+
+    switch (packet_detect_format(frame, length)) {
+    case PACKET_FORMAT_LEGACY:
+        if (packet_decode(frame, length, &pkt) &&
+            (packet_encode(&pkt, out) != length || memcmp(out, frame, length) != 0)) {
+            abort();
+        }
+        break;
+    case PACKET_FORMAT_V2:
+        if (packet_v2_decode(frame, length, &pkt)) {
+            packet_v2_find_tlv(frame, length, PACKET_TLV_BATTERY_MV, &tlv_len);
+        }
+        break;
+    case PACKET_FORMAT_AGGREGATE:
+        packet_aggregate_decode(frame, length, events, PACKET_AGG_MAX_EVENTS);
+        break;
+    case PACKET_FORMAT_COMPACT:
+        packet_compact_decode(frame, length, &pkt);
+        break;
+    case PACKET_FORMAT_ACK:
+        packet_ack_decode(frame, length, &ack);
+        break;
+    case PACKET_FORMAT_ADR:
+        if (packet_adr_decode(frame, length, &adr) &&
+            (packet_adr_encode(&adr, out) != length || memcmp(out, frame, length) != 0)) {
+            abort();
+        }
+        break;
+    default:
+        break;
+    }
+
+    /* FEC runs before format detection on the receiver */
+    uint8_t parity = (uint8_t)((data[0] % (FEC_MAX_PARITY / 2)) + 1) * 2;
+    memcpy(frame, data, length);
+    fec_decode(frame, length, parity);
+
+    return 0;
+}
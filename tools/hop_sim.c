@@ -0,0 +1,214 @@
+/**
+ * Frequency hopping simulation: delivered packets/s vs. node count
+ *
+ * N transmitters send Poisson traffic at one SF. Three set-ups:
+ *   one channel  - everyone on one frequency, continuous RX (today)
+ *   hop + scan   - each node hops per frame over LORA_HOP_CHANNELS with
+ *                  hop_channel() and the long preamble; one SX1262 runs
+ *                  the driver's CAD scan (LORA_HOP_SCAN)
+ *   hop, gateway - the same hopping, received by one demodulator per
+ *                  channel (an 8-channel gateway, or one radio per
+ *                  channel): the upper bound of the channel plan
+ * Overlapping frames on the same channel are both lost (no capture). The
+ * scanning receiver locks on if its CAD hits a preamble with at least
+ * SIM_LOCK_SYMBOLS to go, then is busy until the frame ends; a hit on a
+ * payload costs LORA_HOP_SYNC_SYMBOLS of RX before it scans on.
+ *
+ * Build: see tools/CMakeLists.txt (needs the transmitter's lora_driver.h
+ * for the channel plan and CAD constants)
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <math.h>
+#include "lora_driver.h"
+#include "airtime.h"
+#include "hop.h"
+
+#define SIM_SF               7
+#define SIM_FRAME_BYTES      12        /* v2 single-event frame          */
+#define SIM_INTERVAL_MS      30000     /* Mean time between events/node  */
+#define SIM_DURATION_MS      (3600 * 1000)
+#define SIM_CAD_DETECT       0.9       /* P(CAD sees a frame on air)     */
+#define SIM_LOCK_SYMBOLS     6         /* Preamble left to lock on       */
+#define SIM_RETUNE_US        150       /* DIO1 to next CAD: 4 commands   */
+#define SIM_TURNAROUND_US    100       /* RX_DONE to scanning again      */
+#define SIM_MAX_FRAMES       (500 * (SIM_DURATION_MS / SIM_INTERVAL_MS) * 2)   /* 500 nodes, 2x headroom */
+
+typedef struct {
+    int64_t start_us;
+    uint8_t channel;
+    bool    collided;
+} frame_t;
+
+typedef struct {
+    uint32_t generated;
+    uint32_t clean;             /* Not collided: what a gateway gets  */
+    uint32_t delivered;         /* Caught by the receiver             */
+    uint32_t payload_hits;      /* Scan CAD hit too late to lock on   */
+} result_t;
+
+static frame_t  s_frames[SIM_MAX_FRAMES];
+static uint32_t s_frame_count;
+static uint64_t s_rng;
+
+static double uniform(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 7;
+    s_rng ^= s_rng << 17;
+    return ((s_rng >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static int frame_cmp(const void *a, const void *b)
+{
+    int64_t d = ((const frame_t *)a)->start_us - ((const frame_t *)b)->start_us;
+    return (d > 0) - (d < 0);
+}
+
+static int64_t frame_airtime_us(uint16_t preamble)
+{
+    airtime_params_t p = {
+        .sf = SIM_SF, .bw_hz = 125000, .cr = 1, .preamble = preamble,
+        .implicit_header = false, .crc_on = true,
+    };
+    return airtime_lora_us(&p, SIM_FRAME_BYTES);
+}
+
+/* Every node's frames for the run, in start order. A node sends one
+ * frame at a time; events arriving meanwhile wait for it. */
+static void generate(uint32_t n_nodes, uint8_t channels, int64_t airtime_us)
+{
+    const int64_t end_us = (int64_t)SIM_DURATION_MS * 1000;
+
+    s_rng = 0x9E3779B97F4A7C15ULL;
+    s_frame_count = 0;
+    for (uint32_t node = 0; node < n_nodes; node++) {
+        int64_t  t = 0, free_at = 0;
+        uint32_t index = 0;
+        for (;;) {
+            t += (int64_t)(-log(uniform()) * SIM_INTERVAL_MS * 1000.0);
+            int64_t start = t > free_at ? t : free_at;
+            if (start >= end_us || s_frame_count == SIM_MAX_FRAMES) {
+                break;
+            }
+            s_frames[s_frame_count++] = (frame_t){
+                .start_us = start,
+                .channel  = hop_channel((uint8_t)node, index++, channels),
+            };
+            free_at = start + airtime_us;
+        }
+    }
+    qsort(s_frames, s_frame_count, sizeof(frame_t), frame_cmp);
+
+    /* With equal airtimes, a frame overlapping any earlier one on its
+     * channel overlaps the latest of them */
+    int64_t last_start[HOP_MAX_CHANNELS];
+    int32_t last[HOP_MAX_CHANNELS];
+    for (uint8_t c = 0; c < channels; c++) {
+        last[c] = -1;
+        last_start[c] = INT64_MIN / 2;
+    }
+    for (uint32_t i = 0; i < s_frame_count; i++) {
+        frame_t *f = &s_frames[i];
+        if (last[f->channel] >= 0 && f->start_us < last_start[f->channel] + airtime_us) {
+            f->collided = true;
+            s_frames[last[f->channel]].collided = true;
+        }
+        last[f->channel]       = (int32_t)i;
+        last_start[f->channel] = f->start_us;
+    }
+}
+
+static void count_clean(result_t *r)
+{
+    r->generated = s_frame_count;
+    for (uint32_t i = 0; i < s_frame_count; i++) {
+        r->clean += !s_frames[i].collided;
+    }
+}
+
+/* One SX1262 stepping through the plan, one CAD per channel */
+static void scan(uint8_t channels, int64_t airtime_us, result_t *r)
+{
+    const int64_t symbol_us   = ((int64_t)1000000 << SIM_SF) / 125000;
+    const int64_t cad_us      = (LORA_CAD_SYMBOLS(SIM_SF) + 1) * symbol_us;
+    const int64_t preamble_us = frame_airtime_us(LORA_WAKE_PREAMBLE) -
+                                frame_airtime_us(0);
+    const int64_t end_us      = (int64_t)SIM_DURATION_MS * 1000;
+
+    /* Per channel: first frame that may still be on air */
+    uint32_t cursor[HOP_MAX_CHANNELS] = {0};
+    uint8_t ch = 0;
+    int64_t t  = 0;
+
+    while (t < end_us) {
+        uint32_t *i = &cursor[ch];
+        while (*i < s_frame_count &&
+               (s_frames[*i].channel != ch || s_frames[*i].start_us + airtime_us <= t)) {
+            (*i)++;
+        }
+
+        const frame_t *f = *i < s_frame_count ? &s_frames[*i] : NULL;
+        int64_t cad_end  = t + cad_us;
+        if (f != NULL && f->start_us < cad_end && uniform() < SIM_CAD_DETECT) {
+            if (cad_end + SIM_LOCK_SYMBOLS * symbol_us <= f->start_us + preamble_us) {
+                /* Locked on: busy to the end of the frame, good or not */
+                r->delivered += !f->collided;
+                t = f->start_us + airtime_us + SIM_TURNAROUND_US;
+            } else {
+                /* Payload only: no preamble found before the timeout */
+                r->payload_hits++;
+                t = cad_end + LORA_HOP_SYNC_SYMBOLS * symbol_us + SIM_RETUNE_US;
+            }
+        } else {
+            t = cad_end + SIM_RETUNE_US;
+        }
+        ch = (uint8_t)((ch + 1) % channels);
+    }
+}
+
+int main(void)
+{
+    const int64_t short_us = frame_airtime_us(LORA_STANDARD_PREAMBLE);
+    const int64_t long_us  = frame_airtime_us(LORA_WAKE_PREAMBLE);
+    const double  span_s   = SIM_DURATION_MS / 1000.0;
+
+    printf("Hopping simulation: SF%d, %d B frames, one event per node every %d s "
+           "on average, %d min\n", SIM_SF, SIM_FRAME_BYTES, SIM_INTERVAL_MS / 1000,
+           SIM_DURATION_MS / 60000);
+    printf("Plan: %d channels from %.1f MHz; frames %.1f ms (%d-symbol preamble), "
+           "%.1f ms hopping (%d symbols)\n", LORA_HOP_CHANNELS, LORA_HOP_BASE_HZ / 1e6,
+           short_us / 1000.0, LORA_STANDARD_PREAMBLE, long_us / 1000.0, LORA_WAKE_PREAMBLE);
+    printf("Scan: %d-symbol CAD per channel, detect p=%.2f, full scan %.1f ms\n\n",
+           LORA_CAD_SYMBOLS(SIM_SF), SIM_CAD_DETECT,
+           LORA_HOP_CHANNELS * ((LORA_CAD_SYMBOLS(SIM_SF) + 1) *
+                                ((1 << SIM_SF) * 1e6 / 125000) + SIM_RETUNE_US) / 1000.0);
+
+    printf("%6s %9s | %16s | %16s %12s | %16s\n", "nodes", "offered/s",
+           "one channel /s", "hop + scan /s", "payload hits", "hop, gateway /s");
+
+    const uint32_t counts[] = { 10, 100, 500 };
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        result_t single = {0}, scanned = {0}, gateway = {0};
+
+        generate(counts[i], 1, short_us);
+        count_clean(&single);
+
+        generate(counts[i], LORA_HOP_CHANNELS, long_us);
+        count_clean(&scanned);
+        scan(LORA_HOP_CHANNELS, long_us, &scanned);
+
+        generate(counts[i], LORA_HOP_CHANNELS, short_us);
+        count_clean(&gateway);
+
+        printf("%6u %9.2f | %7.2f (%5.1f%%) | %7.2f (%5.1f%%) %12u | %7.2f (%5.1f%%)\n",
+               counts[i], single.generated / span_s,
+               single.clean / span_s, 100.0 * single.clean / single.generated,
+               scanned.delivered / span_s, 100.0 * scanned.delivered / scanned.generated,
+               scanned.payload_hits,
+               gateway.clean / span_s, 100.0 * gateway.clean / gateway.generated);
+    }
+    return 0;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+typedef struct spi_device_t *spi_device_handle_t;
+
+typedef enum {
+    SPI1_HOST,
+    SPI2_HOST,
+    SPI3_HOST,
+} spi_host_device_t;
+
+#define SPI_DMA_CH_AUTO           3
+
+#define SPI_TRANS_USE_RXDATA      (1 << 2)
+#define SPI_TRANS_USE_TXDATA      (1 << 3)
+#define SPI_TRANS_CS_KEEP_ACTIVE  (1 << 8)
+
+typedef struct {
+    int mosi_io_num;
+    int miso_io_num;
+    int sclk_io_num;
+    int quadwp_io_num;
+    int quadhd_io_num;
+    int max_transfer_sz;
+} spi_bus_config_t;
+
+typedef struct {
+    uint32_t flags;
+    size_t   length;       /* bits */
+    size_t   rxlength;     /* bits, 0 = length */
+    void    *user;
+    union {
+        const void *tx_buffer;
+        uint8_t     tx_data[4];
+    };
+    union {
+        void   *rx_buffer;
+        uint8_t rx_data[4];
+    };
+} spi_transaction_t;
+
+typedef void (*transaction_cb_t)(spi_transaction_t *trans);
+
+typedef struct {
+    uint8_t  mode;
+    uint16_t cs_ena_pretrans;
+    uint8_t  cs_ena_posttrans;
+    int      clock_speed_hz;
+    int      spics_io_num;
+    uint32_t flags;
+    int      queue_size;
+    transaction_cb_t pre_cb;     /* Before each transaction (ISR when queued) */
+    transaction_cb_t post_cb;
+} spi_device_interface_config_t;
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *bus,
+                             int dma_chan);
+esp_err_t spi_bus_add_device(spi_host_device_t host,
+                             const spi_device_interface_config_t *dev,
+                             spi_device_handle_t *handle);
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *t);
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle,
+                                      spi_transaction_t *t);
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *t,
+                                 TickType_t ticks_to_wait);
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle,
+                                      spi_transaction_t **t, TickType_t ticks_to_wait);
+esp_err_t spi_device_acquire_bus(spi_device_handle_t handle, TickType_t wait);
+void      spi_device_release_bus(spi_device_handle_t handle);
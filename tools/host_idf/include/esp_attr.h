@@ -0,0 +1,8 @@
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define WORD_ALIGNED_ATTR  __attribute__((aligned(4)))
+#define DMA_ATTR           WORD_ALIGNED_ATTR
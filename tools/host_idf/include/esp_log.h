@@ -0,0 +1,27 @@
+#pragma once
+#include <stdio.h>
+#include <stdarg.h>
+
+/* Not format-checked: firmware formats assume the Xtensa/RISC-V types
+ * (uint32_t = unsigned long), which differ from the host's */
+static inline void esp_log_host(const char *level, const char *tag, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    printf("%s %s: ", level, tag);
+    vprintf(fmt, ap);
+    printf("\n");
+    va_end(ap);
+}
+
+static inline void esp_log_discard(const char *tag, const char *fmt, ...)
+{
+    (void)tag;
+    (void)fmt;
+}
+
+/* Errors and warnings only - info logs would swamp the benchmarks */
+#define ESP_LOGE(tag, fmt, ...)  esp_log_host("E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...)  esp_log_host("W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...)  esp_log_discard(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...)  esp_log_discard(tag, fmt, ##__VA_ARGS__)
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Deterministic on the host so simulator runs are repeatable */
+uint32_t esp_random(void);
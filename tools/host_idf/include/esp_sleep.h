@@ -0,0 +1,9 @@
+#pragma once
+
+typedef enum {
+    ESP_SLEEP_WAKEUP_UNDEFINED = 0,   /* Cold boot / not a sleep wake */
+    ESP_SLEEP_WAKEUP_EXT1      = 3,
+    ESP_SLEEP_WAKEUP_TIMER     = 4,
+} esp_sleep_wakeup_cause_t;
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void);
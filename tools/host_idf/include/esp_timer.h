@@ -0,0 +1,5 @@
+#pragma once
+#include <stdint.h>
+
+/* Simulated microsecond clock (advances only when the code waits) */
+int64_t esp_timer_get_time(void);
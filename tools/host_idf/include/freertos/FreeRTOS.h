@@ -0,0 +1,21 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_attr.h"
+
+typedef uint32_t TickType_t;
+typedef int      BaseType_t;
+typedef unsigned UBaseType_t;
+
+#define pdFALSE          0
+#define pdTRUE           1
+#define pdPASS           pdTRUE
+#define portMAX_DELAY    0xFFFFFFFFu
+/* CONFIG_FREERTOS_HZ=100 in both sdkconfigs; pdMS_TO_TICKS() truncates
+ * like ESP-IDF's, so waits under a tick become 0 here as on the target */
+#define configTICK_RATE_HZ  100
+#define portTICK_PERIOD_MS  (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+
+#define portYIELD_FROM_ISR(woken)  ((void)(woken))
@@ -0,0 +1,12 @@
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+
+/* Simulated scheduler: one task, time only moves when it blocks */
+void         vTaskDelay(TickType_t ticks);
+TickType_t   xTaskGetTickCount(void);
+TickType_t   xTaskGetTickCountFromISR(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+uint32_t     ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+void         vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken);
@@ -0,0 +1,11 @@
+#pragma once
+#include <stdint.h>
+#include "soc/gpio_struct.h"
+#include "driver/gpio.h"
+
+/* ISR-safe pin read; the simulator answers it like gpio_get_level() */
+static inline int gpio_ll_get_level(gpio_dev_t *hw, uint32_t gpio_num)
+{
+    (void)hw;
+    return gpio_get_level((gpio_num_t)gpio_num);
+}
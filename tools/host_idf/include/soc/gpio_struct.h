@@ -0,0 +1,8 @@
+#pragma once
+
+/* Register block stand-in; the simulator only needs its address */
+typedef struct {
+    int unused;
+} gpio_dev_t;
+
+extern gpio_dev_t GPIO;
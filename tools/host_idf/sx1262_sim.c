@@ -0,0 +1,801 @@
+#include "sx1262_sim.h"
+#include "lora_driver.h"
+#include "driver/spi_master.h"
+#include "driver/gpio.h"
+#include "soc/gpio_struct.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "esp_sleep.h"
+#include "nvs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/* Opcodes the simulator answers (SX1262 datasheet, section 13) */
+#define OP_CLR_IRQ_STATUS     0x02
+#define OP_WRITE_BUFFER       0x0E
+#define OP_GET_IRQ_STATUS     0x12
+#define OP_GET_RX_BUF_STATUS  0x13
+#define OP_GET_PKT_STATUS     0x14
+#define OP_READ_BUFFER        0x1E
+#define OP_SET_TX             0x83
+#define OP_SET_RX             0x82
+#define OP_SET_STANDBY        0x80
+#define OP_SET_SLEEP          0x84
+#define OP_SET_RF_FREQ        0x86
+#define OP_SET_DIO3_AS_TCXO   0x97
+#define OP_CALIBRATE          0x89
+#define OP_CALIBRATE_IMAGE    0x98
+#define OP_SET_CAD_PARAMS     0x88
+#define OP_SET_CAD            0xC5
+#define OP_SET_RX_DUTY_CYCLE  0x94
+
+#define IRQ_TX_DONE           (1 << 0)
+#define IRQ_RX_DONE           (1 << 1)
+#define IRQ_CAD_DONE          (1 << 7)
+#define IRQ_CAD_DETECTED      (1 << 8)
+#define IRQ_TIMEOUT           (1 << 9)
+
+/* SET_CAD_PARAMS exit mode: stay in RX after a detection */
+#define SIM_CAD_EXIT_RX       0x01
+
+/* Sleep (warm start) to STDBY_RC after the waking NSS edge */
+#define SIM_WARM_WAKE_US      340
+
+/* Fixed per-transaction cost on top of the bit time (CS setup, driver) */
+#define SIM_TRANS_OVERHEAD_NS 2000
+
+static uint8_t  s_buffer[256];
+static uint16_t s_irq;
+static uint8_t  s_rx_len;
+static uint8_t  s_tx_len;
+static int      s_rssi_dbm;
+static int      s_clock_hz = 1000000;
+static transaction_cb_t s_pre_cb;
+static bool     s_bus_acquired;     /* spi_device_acquire_bus() held   */
+static bool     s_queued;           /* Running a queued transaction    */
+static uint8_t  s_stretch_opcode;   /* Command whose BUSY time grows   */
+static uint32_t s_stretch_us;       /* Extra BUSY time, 0 = none       */
+
+/* Queued transactions run at queue time; results wait here */
+#define SIM_SPI_QUEUE  16
+static spi_transaction_t *s_trans_done[SIM_SPI_QUEUE];
+static uint8_t  s_trans_head;
+static uint8_t  s_trans_count;
+
+gpio_dev_t GPIO;
+
+static void   (*s_dio1_isr)(void *);
+static void    *s_dio1_arg;
+
+static void   (*s_busy_isr)(void *);
+static void    *s_busy_arg;
+static bool     s_busy_intr_enabled;
+
+static sx1262_sim_stats_t s_stats;
+
+/* Simulated time; FreeRTOS ticks every SIM_TICK_US, as on the target */
+#define SIM_TICK_US  (1000000 / configTICK_RATE_HZ)
+static int64_t  s_now_us;
+static int64_t  s_busy_until_us;
+static int64_t  s_tx_done_at_us = -1;    /* TX_DONE due, -1 = no TX */
+static int64_t  s_cad_done_at_us = -1;   /* CAD_DONE due, -1 = no CAD */
+static uint16_t s_cad_result;            /* IRQ bits raised with it     */
+static uint8_t  s_cad_symbols = 2;
+static uint8_t  s_cad_exit;              /* SET_CAD_PARAMS exit mode    */
+static uint32_t s_cad_timeout;           /* CAD_RX timeout, 15.625 us   */
+static int64_t  s_rx_timeout_at_us = -1; /* CAD_RX TIMEOUT due, -1 = none */
+static uint32_t s_channel_busy_cads;     /* CADs left that detect       */
+static uint32_t s_random = 0x1234567;
+static uint32_t s_notify;
+
+/* SET_SLEEP received; BUSY high until the next NSS edge */
+static bool     s_asleep;
+
+/* SET_RX_DUTY_CYCLE: modelled as asleep until a frame arrives, which
+ * leaves the chip in standby like on real hardware */
+static bool     s_rx_cycling;
+
+/* NRESET: the chip is held in reset while the pin drives a 0. The output
+ * latch reads 0 after any ESP32 reset, deep-sleep wake included, and the
+ * pin floats (module pull-up, chip running) until gpio_config() enables
+ * the output. */
+static bool     s_rst_output;
+static uint32_t s_rst_latch;
+static bool     s_in_reset;
+static esp_sleep_wakeup_cause_t s_wakeup_cause = ESP_SLEEP_WAKEUP_UNDEFINED;
+
+/* Rough BUSY-high times after each command (datasheet orders of
+ * magnitude, not measurements) */
+static uint32_t sim_busy_us(uint8_t opcode)
+{
+    switch (opcode) {
+    case OP_CALIBRATE:        return 3500;
+    case OP_CALIBRATE_IMAGE:  return 3000;
+    case OP_SET_DIO3_AS_TCXO: return 100;
+    case OP_SET_TX:
+    case OP_SET_RX:           return 60;
+    case OP_SET_RF_FREQ:
+    case OP_SET_STANDBY:      return 20;
+    default:                  return 5;
+    }
+}
+
+/* ─── Radio model ─────────────────────────────────────────────── */
+
+static void sim_raise_irq(uint16_t bits)
+{
+    uint16_t before = s_irq;
+    s_irq |= bits;
+
+    /* DIO1 rising edge */
+    if (before == 0 && s_irq != 0 && s_dio1_isr) {
+        s_dio1_isr(s_dio1_arg);
+    }
+}
+
+/* Next pending hardware event (BUSY edge or TX_DONE), INT64_MAX if none */
+static int64_t sim_next_event_us(void)
+{
+    int64_t next = INT64_MAX;
+    if (s_busy_until_us > s_now_us) {
+        next = s_busy_until_us;
+    }
+    if (s_tx_done_at_us >= 0 && s_tx_done_at_us < next) {
+        next = s_tx_done_at_us;
+    }
+    if (s_cad_done_at_us >= 0 && s_cad_done_at_us < next) {
+        next = s_cad_done_at_us;
+    }
+    if (s_rx_timeout_at_us >= 0 && s_rx_timeout_at_us < next) {
+        next = s_rx_timeout_at_us;
+    }
+    return next;
+}
+
+/* Move the clock forward, firing every event it passes in order */
+static void sim_advance(int64_t us)
+{
+    int64_t target = s_now_us + us;
+
+    while (sim_next_event_us() <= target) {
+        s_now_us = sim_next_event_us();
+
+        if (s_now_us == s_busy_until_us && s_busy_isr && s_busy_intr_enabled) {
+            s_busy_isr(s_busy_arg);
+        }
+        if (s_now_us == s_tx_done_at_us) {
+            s_tx_done_at_us = -1;
+            sim_raise_irq(IRQ_TX_DONE);
+        }
+        if (s_now_us == s_cad_done_at_us) {
+            s_cad_done_at_us = -1;
+            if ((s_cad_result & IRQ_CAD_DETECTED) && s_cad_exit == SIM_CAD_EXIT_RX) {
+                /* Listening on; no frame follows unless one is injected */
+                s_rx_timeout_at_us = s_now_us + (int64_t)s_cad_timeout * 15625 / 1000;
+            }
+            sim_raise_irq(s_cad_result);
+        }
+        if (s_now_us == s_rx_timeout_at_us) {
+            s_rx_timeout_at_us = -1;
+            sim_raise_irq(IRQ_TIMEOUT);
+        }
+        if (s_now_us == s_busy_until_us) {
+            /* Edge handled; keep it from being found again */
+            s_busy_until_us = s_now_us - 1;
+        }
+    }
+    s_now_us = target;
+}
+
+/* Blocking call: run the clock event by event until ready() or timeout */
+/* A block of n ticks ends at the n-th tick interrupt from now, so
+ * anywhere from n-1 to n tick periods later */
+static int64_t sim_tick_deadline(TickType_t ticks)
+{
+    return (s_now_us / SIM_TICK_US + (int64_t)ticks) * SIM_TICK_US;
+}
+
+static bool sim_block(bool (*ready)(void *), void *ctx, TickType_t ticks)
+{
+    int64_t deadline = (ticks == portMAX_DELAY) ? INT64_MAX : sim_tick_deadline(ticks);
+    while (!ready(ctx)) {
+        int64_t next = sim_next_event_us();
+        if (next > deadline) {
+            sim_advance(deadline - s_now_us);
+            return ready(ctx);
+        }
+        if (next == INT64_MAX) {
+            fprintf(stderr, "sx1262_sim: task blocked forever with nothing pending\n");
+            abort();
+        }
+        sim_advance(next - s_now_us);
+    }
+    return true;
+}
+
+static void sim_execute(const uint8_t *tx, uint8_t *rx, size_t n)
+{
+    uint8_t resp[SX_SIM_MAX_TRANSFER] = {0};
+
+    switch (tx[0]) {
+    case OP_GET_IRQ_STATUS:
+        resp[2] = (uint8_t)(s_irq >> 8);
+        resp[3] = (uint8_t)(s_irq);
+        break;
+    case OP_CLR_IRQ_STATUS:
+        if (n >= 3) {
+            s_irq &= (uint16_t)~((tx[1] << 8) | tx[2]);
+        }
+        break;
+    case OP_WRITE_BUFFER:
+        if (n >= 2) {
+            s_tx_len = (uint8_t)(n - 2);
+            for (size_t i = 2; i < n; i++) {
+                s_buffer[(uint8_t)(tx[1] + i - 2)] = tx[i];
+            }
+        }
+        break;
+    case OP_READ_BUFFER:
+        for (size_t i = 3; i < n; i++) {
+            resp[i] = s_buffer[(uint8_t)(tx[1] + i - 3)];
+        }
+        break;
+    case OP_GET_RX_BUF_STATUS:
+        resp[2] = s_rx_len;
+        resp[3] = 0x00;
+        break;
+    case OP_GET_PKT_STATUS:
+        resp[2] = (uint8_t)(-s_rssi_dbm * 2);
+        resp[3] = 0;
+        resp[4] = (uint8_t)(-s_rssi_dbm * 2);
+        break;
+    case OP_SET_TX:
+        /* TX_DONE after the frame's time-on-air */
+        s_tx_done_at_us = s_now_us + lora_driver_airtime_us(LORA_PROFILE, s_tx_len);
+        break;
+    case OP_SET_CAD_PARAMS:
+        if (n >= 2) {
+            s_cad_symbols = (uint8_t)(1u << tx[1]);
+        }
+        if (n >= 8) {
+            s_cad_exit    = tx[4];
+            s_cad_timeout = ((uint32_t)tx[5] << 16) | ((uint32_t)tx[6] << 8) | tx[7];
+        }
+        break;
+    case OP_SET_CAD: {
+        /* CAD_DONE after the listened symbols plus one of processing */
+        lora_radio_config_t cfg;
+        lora_driver_get_config(&cfg);
+        int64_t symbol_us = ((int64_t)1000000 << cfg.spreading_factor) / cfg.bandwidth_hz;
+        s_cad_done_at_us = s_now_us + (s_cad_symbols + 1) * symbol_us;
+        s_cad_result = IRQ_CAD_DONE;
+        if (s_channel_busy_cads > 0) {
+            s_channel_busy_cads--;
+            s_cad_result |= IRQ_CAD_DETECTED;
+        }
+        break;
+    }
+    case OP_SET_STANDBY:
+        s_tx_done_at_us    = -1;
+        s_cad_done_at_us   = -1;
+        s_rx_timeout_at_us = -1;
+        break;
+    case OP_SET_SLEEP:
+        s_tx_done_at_us    = -1;
+        s_cad_done_at_us   = -1;
+        s_rx_timeout_at_us = -1;
+        s_asleep = true;
+        break;
+    case OP_SET_RX_DUTY_CYCLE:
+        s_asleep     = true;
+        s_rx_cycling = true;
+        break;
+    default:
+        break;
+    }
+
+    if (rx) {
+        memcpy(rx, resp, n);
+    }
+}
+
+void sx1262_sim_inject_rx(const uint8_t *data, uint8_t length, int rssi_dbm)
+{
+    memcpy(s_buffer, data, length);
+    s_rx_len   = length;
+    s_rssi_dbm = rssi_dbm;
+    s_rx_timeout_at_us = -1;     /* The frame ends a CAD_RX listen */
+    if (s_rx_cycling) {
+        /* Caught by a listen window; the chip settled long ago */
+        s_asleep        = false;
+        s_rx_cycling    = false;
+        s_busy_until_us = s_now_us;
+    }
+    sim_raise_irq(IRQ_RX_DONE);
+}
+
+uint8_t sx1262_sim_last_tx(uint8_t *data)
+{
+    memcpy(data, s_buffer, s_tx_len);
+    return s_tx_len;
+}
+
+const sx1262_sim_stats_t *sx1262_sim_stats(void)
+{
+    return &s_stats;
+}
+
+void sx1262_sim_reset_stats(void)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+}
+
+void sx1262_sim_set_channel_busy(uint32_t cads)
+{
+    s_channel_busy_cads = cads;
+}
+
+void sx1262_sim_stretch_busy(uint8_t opcode, uint32_t extra_us)
+{
+    s_stretch_opcode = opcode;
+    s_stretch_us     = extra_us;
+}
+
+void sx1262_sim_deep_sleep_wake(void)
+{
+    s_wakeup_cause = ESP_SLEEP_WAKEUP_EXT1;
+    s_rst_output   = false;
+    s_rst_latch    = 0;
+}
+
+/* ─── SPI ─────────────────────────────────────────────────────── */
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *bus,
+                             int dma_chan)
+{
+    (void)host; (void)bus; (void)dma_chan;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host,
+                             const spi_device_interface_config_t *dev,
+                             spi_device_handle_t *handle)
+{
+    (void)host;
+    s_clock_hz = dev->clock_speed_hz;
+    s_pre_cb   = dev->pre_cb;
+    *handle = (spi_device_handle_t)&s_clock_hz;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle,
+                                      spi_transaction_t *t)
+{
+    (void)handle;
+    size_t n = t->length / 8;
+    if (n == 0 || n > SX_SIM_MAX_TRANSFER) {
+        fprintf(stderr, "sx1262_sim: bad transaction length %zu\n", n);
+        abort();
+    }
+
+    const uint8_t *tx = (t->flags & SPI_TRANS_USE_TXDATA) ? t->tx_data
+                                                          : t->tx_buffer;
+    uint8_t *rx = (t->flags & SPI_TRANS_USE_RXDATA) ? t->rx_data
+                                                    : t->rx_buffer;
+    if (s_trans_count > 0) {
+        fprintf(stderr, "sx1262_sim: polling transmit with queued transactions pending\n");
+        abort();
+    }
+    if ((t->flags & SPI_TRANS_USE_TXDATA) && n > 4) {
+        fprintf(stderr, "sx1262_sim: TXDATA transaction longer than 4 bytes\n");
+        abort();
+    }
+
+    if (s_pre_cb) {
+        s_pre_cb(t);
+    }
+
+    s_stats.transactions++;
+    s_stats.bytes  += (uint32_t)n;
+    s_stats.bus_ns += (uint64_t)n * 8 * 1000000000ULL / (uint64_t)s_clock_hz
+                    + SIM_TRANS_OVERHEAD_NS;
+    s_stats.per_opcode[tx[0]]++;
+
+    if (s_in_reset) {
+        /* Nothing is listening; MISO reads back zeros */
+        if (rx) {
+            memset(rx, 0, n);
+        }
+        sim_advance((int64_t)(n * 8 * 1000000ULL / (uint64_t)s_clock_hz));
+        return ESP_OK;
+    }
+
+    if (s_asleep) {
+        /* The NSS edge wakes the chip; the command is not executed */
+        s_asleep     = false;
+        s_rx_cycling = false;
+        sim_advance((int64_t)(n * 8 * 1000000ULL / (uint64_t)s_clock_hz));
+        s_busy_until_us = s_now_us + SIM_WARM_WAKE_US;
+        return ESP_OK;
+    }
+
+    if (s_now_us < s_busy_until_us) {
+        /* Queued ones are sent by the SPI ISR, which cannot hold them
+         * back; the driver has to notice and resend. Anywhere else it
+         * should have waited. */
+        if (!s_queued) {
+            fprintf(stderr, "sx1262_sim: opcode 0x%02X sent while BUSY\n", tx[0]);
+            abort();
+        }
+        s_stats.ignored++;
+        sim_advance((int64_t)(n * 8 * 1000000ULL / (uint64_t)s_clock_hz));
+        return ESP_OK;
+    }
+
+    sim_execute(tx, rx, n);
+    sim_advance((int64_t)(n * 8 * 1000000ULL / (uint64_t)s_clock_hz));
+    s_busy_until_us = s_now_us + sim_busy_us(tx[0]);
+    if (s_stretch_us > 0 && tx[0] == s_stretch_opcode) {
+        s_busy_until_us += s_stretch_us;
+        s_stretch_us = 0;
+    }
+    return ESP_OK;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *t)
+{
+    return spi_device_polling_transmit(handle, t);
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *t,
+                                 TickType_t ticks_to_wait)
+{
+    (void)ticks_to_wait;
+    if (s_trans_count == SIM_SPI_QUEUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    /* Back-to-back on the bus: run it now, hand the result back later */
+    uint8_t pending = s_trans_count;
+    s_trans_count = 0;
+    s_queued = true;
+    spi_device_polling_transmit(handle, t);
+    s_queued = false;
+    s_trans_count = pending;
+
+    s_trans_done[(s_trans_head + s_trans_count) % SIM_SPI_QUEUE] = t;
+    s_trans_count++;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle,
+                                      spi_transaction_t **t, TickType_t ticks_to_wait)
+{
+    (void)handle; (void)ticks_to_wait;
+    if (s_trans_count == 0) {
+        return ESP_ERR_TIMEOUT;
+    }
+    *t = s_trans_done[s_trans_head];
+    s_trans_head = (s_trans_head + 1) % SIM_SPI_QUEUE;
+    s_trans_count--;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_acquire_bus(spi_device_handle_t handle, TickType_t wait)
+{
+    (void)handle; (void)wait;
+    if (s_bus_acquired) {
+        fprintf(stderr, "sx1262_sim: bus acquired twice\n");
+        abort();
+    }
+    s_bus_acquired = true;
+    return ESP_OK;
+}
+
+void spi_device_release_bus(spi_device_handle_t handle)
+{
+    (void)handle;
+    if (!s_bus_acquired) {
+        fprintf(stderr, "sx1262_sim: bus released without being acquired\n");
+        abort();
+    }
+    s_bus_acquired = false;
+}
+
+/* ─── GPIO ────────────────────────────────────────────────────── */
+
+/* Follow NRESET: a low pin loses everything, sleep state included */
+static void sim_update_reset(void)
+{
+    bool low = s_rst_output && s_rst_latch == 0;
+    if (low && !s_in_reset) {
+        s_in_reset         = true;
+        s_irq              = 0;
+        s_asleep           = false;
+        s_rx_cycling       = false;
+        s_tx_done_at_us    = -1;
+        s_cad_done_at_us   = -1;
+        s_rx_timeout_at_us = -1;
+    } else if (!low && s_in_reset) {
+        /* Leaving reset: the chip boots with BUSY high */
+        s_in_reset      = false;
+        s_busy_until_us = s_now_us + 3500;
+    }
+}
+
+esp_err_t gpio_config(const gpio_config_t *conf)
+{
+    if ((conf->pin_bit_mask & (1ULL << LORA_PIN_RST)) &&
+        conf->mode == GPIO_MODE_OUTPUT) {
+        s_rst_output = true;
+        sim_update_reset();
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio, uint32_t level)
+{
+    if (gpio == LORA_PIN_RST) {
+        s_rst_latch = level;
+        sim_update_reset();
+    }
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio)
+{
+    if (gpio == LORA_PIN_IRQ) {
+        return s_irq != 0;
+    }
+    if (gpio == LORA_PIN_BUSY) {
+        return s_in_reset || s_asleep || s_now_us < s_busy_until_us;
+    }
+    return 0;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio, gpio_int_type_t type)
+{
+    (void)gpio; (void)type;
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t gpio)
+{
+    if (gpio == LORA_PIN_BUSY) {
+        s_busy_intr_enabled = true;
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t gpio)
+{
+    if (gpio == LORA_PIN_BUSY) {
+        s_busy_intr_enabled = false;
+    }
+    return ESP_OK;
+}
+esp_err_t gpio_install_isr_service(int flags) { (void)flags; return ESP_OK; }
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio, void (*isr)(void *), void *arg)
+{
+    if (gpio == LORA_PIN_IRQ) {
+        s_dio1_isr = isr;
+        s_dio1_arg = arg;
+    } else if (gpio == LORA_PIN_BUSY) {
+        s_busy_isr = isr;
+        s_busy_arg = arg;
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio)
+{
+    if (gpio == LORA_PIN_IRQ) {
+        s_dio1_isr = NULL;
+    } else if (gpio == LORA_PIN_BUSY) {
+        s_busy_isr = NULL;
+    }
+    return ESP_OK;
+}
+
+/* ─── FreeRTOS ────────────────────────────────────────────────── */
+
+void vTaskDelay(TickType_t ticks)              { sim_advance(sim_tick_deadline(ticks) - s_now_us); }
+TickType_t xTaskGetTickCount(void)             { return (TickType_t)(s_now_us / SIM_TICK_US); }
+TickType_t xTaskGetTickCountFromISR(void)      { return (TickType_t)(s_now_us / SIM_TICK_US); }
+TaskHandle_t xTaskGetCurrentTaskHandle(void)   { return (TaskHandle_t)&s_now_us; }
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken)
+{
+    (void)task;
+    s_notify++;
+    if (woken) {
+        *woken = pdTRUE;
+    }
+}
+
+static bool sim_notified(void *ctx)
+{
+    (void)ctx;
+    return s_notify > 0;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    if (!sim_block(sim_notified, NULL, ticks)) {
+        return 0;
+    }
+
+    uint32_t value = s_notify;
+    s_notify = clear ? 0 : s_notify - 1;
+    return value;
+}
+
+struct sim_queue {
+    uint8_t    *items;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    QueueHandle_t q = calloc(1, sizeof(*q));
+    q->items     = calloc(length, item_size);
+    q->length    = length;
+    q->item_size = item_size;
+    return q;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken)
+{
+    if (q->count == q->length) {
+        return pdFALSE;
+    }
+    UBaseType_t tail = (q->head + q->count) % q->length;
+    memcpy(q->items + tail * q->item_size, item, q->item_size);
+    q->count++;
+    if (woken) {
+        *woken = pdTRUE;
+    }
+    return pdTRUE;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks)
+{
+    (void)ticks;
+    return xQueueSendFromISR(q, item, NULL);
+}
+
+static bool sim_queue_ready(void *ctx)
+{
+    return ((QueueHandle_t)ctx)->count > 0;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks)
+{
+    if (!sim_block(sim_queue_ready, q, ticks)) {
+        return pdFALSE;
+    }
+    memcpy(item, q->items + q->head * q->item_size, q->item_size);
+    q->head = (q->head + 1) % q->length;
+    q->count--;
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+    return q->count;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return s_now_us;
+}
+
+void esp_rom_delay_us(uint32_t us)
+{
+    sim_advance(us);
+}
+
+/* ─── NVS ─────────────────────────────────────────────────────── */
+
+/* A few blobs in RAM, keyed by "namespace/key"; lost at exit */
+#define SIM_NVS_ENTRIES  4
+#define SIM_NVS_BLOB_MAX 64
+
+static struct {
+    char   name[32];
+    size_t size;
+    uint8_t data[SIM_NVS_BLOB_MAX];
+} s_nvs[SIM_NVS_ENTRIES];
+static const char *s_nvs_namespace[SIM_NVS_ENTRIES];
+static uint8_t s_nvs_handles;
+
+static int sim_nvs_find(nvs_handle_t handle, const char *key, bool create)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%s/%s", s_nvs_namespace[handle], key);
+    for (int i = 0; i < SIM_NVS_ENTRIES; i++) {
+        if (strcmp(s_nvs[i].name, name) == 0) {
+            return i;
+        }
+    }
+    if (create) {
+        for (int i = 0; i < SIM_NVS_ENTRIES; i++) {
+            if (s_nvs[i].name[0] == '\0') {
+                strcpy(s_nvs[i].name, name);
+                return i;
+            }
+        }
+    }
+    return -1;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *handle)
+{
+    (void)mode;
+    if (s_nvs_handles == SIM_NVS_ENTRIES) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_nvs_namespace[s_nvs_handles] = name;
+    *handle = s_nvs_handles++;
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out, size_t *length)
+{
+    int i = sim_nvs_find(handle, key, false);
+    if (i < 0) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (*length < s_nvs[i].size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(out, s_nvs[i].data, s_nvs[i].size);
+    *length = s_nvs[i].size;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    int i = sim_nvs_find(handle, key, true);
+    if (i < 0 || length > SIM_NVS_BLOB_MAX) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(s_nvs[i].data, value, length);
+    s_nvs[i].size = length;
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) { (void)handle; return ESP_OK; }
+
+void nvs_close(nvs_handle_t handle)
+{
+    if (handle + 1 == s_nvs_handles) {
+        s_nvs_handles--;
+    }
+}
+
+/* ─── Misc ────────────────────────────────────────────────────── */
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void)
+{
+    return s_wakeup_cause;
+}
+
+uint32_t esp_random(void)
+{
+    s_random = s_random * 1103515245u + 12345u;
+    return s_random >> 8;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    return code == ESP_OK ? "ESP_OK" : "ESP_FAIL";
+}
@@ -0,0 +1,81 @@
+/**
+ * Host-side SX1262 simulator behind the ESP-IDF shim
+ *
+ * Links with a lora_driver.c copy in place of the real SPI/GPIO/FreeRTOS
+ * drivers. Answers the opcodes the driver uses, raises DIO1 (and calls
+ * its ISR) on TX_DONE / RX_DONE, and counts SPI traffic so host tools can
+ * measure what the driver puts on the bus.
+ */
+#ifndef SX1262_SIM_H
+#define SX1262_SIM_H
+
+#include <stdint.h>
+
+/* Longest SPI transaction accepted (READ_BUFFER of a full 255-byte frame) */
+#define SX_SIM_MAX_TRANSFER  260
+
+typedef struct {
+    uint32_t transactions;          /* SPI transactions (CS cycles)     */
+    uint32_t bytes;                 /* Bytes clocked in either direction */
+    uint64_t bus_ns;                /* Clock time at the device's speed */
+    uint32_t per_opcode[256];       /* Transactions by first byte       */
+    uint32_t ignored;               /* Queued commands sent while BUSY  */
+} sx1262_sim_stats_t;
+
+/**
+ * @brief Place a received frame in the radio buffer and raise RX_DONE
+ * @param data     Frame bytes
+ * @param length   Frame length
+ * @param rssi_dbm Packet RSSI reported by GET_PKT_STATUS
+ */
+void sx1262_sim_inject_rx(const uint8_t *data, uint8_t length, int rssi_dbm);
+
+/**
+ * @brief Copy of the last frame the driver transmitted
+ * @param data Destination (minimum 256 bytes)
+ * @return Frame length
+ */
+uint8_t sx1262_sim_last_tx(uint8_t *data);
+
+/**
+ * @brief SPI counters since the last reset
+ */
+const sx1262_sim_stats_t *sx1262_sim_stats(void);
+
+/**
+ * @brief Zero the SPI counters
+ */
+void sx1262_sim_reset_stats(void);
+
+/**
+ * @brief Make the next CADs report LoRa activity on the channel
+ * With the CAD_RX exit mode a detecting CAD leaves the chip listening:
+ * TIMEOUT follows after the programmed timeout unless a frame is
+ * injected first.
+ *
+ * @param cads Number of SET_CAD runs that detect; later ones are clear
+ */
+void sx1262_sim_set_channel_busy(uint32_t cads);
+
+/**
+ * @brief Keep BUSY high longer after the next run of one command
+ *
+ * A queued command that arrives meanwhile is ignored and counted in
+ * sx1262_sim_stats()->ignored; a polling one aborts as usual.
+ *
+ * @param opcode   Command to slow down
+ * @param extra_us BUSY time added on top of the usual
+ */
+void sx1262_sim_stretch_busy(uint8_t opcode, uint32_t extra_us);
+
+/**
+ * @brief Make the next boot look like a deep-sleep wake (PIR, ext1)
+ *
+ * The radio keeps whatever state it was left in, as the real module
+ * does while the ESP32 sleeps. The ESP32 side comes back with the RST
+ * output latch at 0: enabling the pin as an output before setting it
+ * high holds the chip in reset (BUSY high, commands ignored).
+ */
+void sx1262_sim_deep_sleep_wake(void);
+
+#endif /* SX1262_SIM_H */
@@ -0,0 +1,235 @@
+/**
+ * Listen-before-talk simulation: delivery vs. node count
+ *
+ * N transmitters share one channel and SF, each sending Poisson traffic.
+ * Pure ALOHA (the driver with LORA_LBT_ENABLED 0) is compared with the
+ * driver's CAD policy: one CAD of LORA_CAD_SYMBOLS symbols, then a random
+ * 1..2^n slot backoff while busy, sending anyway after
+ * LORA_LBT_MAX_ATTEMPTS. Overlapping frames are both lost (no capture);
+ * a CAD notices a frame on air with probability SIM_CAD_DETECT. Every
+ * node hears every other one (no hidden terminals).
+ *
+ * Build: see tools/CMakeLists.txt (needs the transmitter's lora_driver.h
+ * for the LBT constants)
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "lora_driver.h"
+#include "airtime.h"
+
+#define SIM_SF               7
+#define SIM_FRAME_BYTES      12        /* v2 single-event frame          */
+#define SIM_INTERVAL_MS      30000     /* Mean time between events/node  */
+#define SIM_DURATION_MS      (3600 * 1000)
+#define SIM_QUEUE_MAX        5         /* TX_QUEUE_SIZE in app_main.c    */
+#define SIM_CAD_DETECT       0.9       /* P(CAD sees a frame on air)     */
+#define SIM_TURNAROUND_US    300       /* CAD done to SET_TX on air      */
+#define SIM_TX_RING          8192
+
+typedef enum { NODE_IDLE, NODE_ATTEMPT, NODE_CAD, NODE_TX } node_state_t;
+
+typedef struct {
+    node_state_t state;
+    int64_t  next_arrival_us;
+    int64_t  next_action_us;
+    int64_t  cad_start_us;
+    int64_t  head_since_us;     /* When the head frame reached the front */
+    uint8_t  pending;
+    uint8_t  busy;              /* Busy CADs for the head frame       */
+    uint32_t tx_slot;           /* Its entry in the TX ring           */
+} node_t;
+
+typedef struct {
+    int64_t start_us;
+    int64_t end_us;
+} tx_t;
+
+typedef struct {
+    uint32_t generated;
+    uint32_t delivered;
+    uint32_t overflow;          /* Dropped: node queue full           */
+    uint32_t forced;
+    double   latency_ms;        /* Sum over delivered frames          */
+    double   busy_us;           /* Channel time with any frame on air */
+} result_t;
+
+static node_t   s_nodes[1000];
+static tx_t     s_tx[SIM_TX_RING];
+static uint32_t s_tx_count;
+static uint64_t s_rng;
+
+static double uniform(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 7;
+    s_rng ^= s_rng << 17;
+    return ((s_rng >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static int64_t exp_interval_us(void)
+{
+    return (int64_t)(-log(uniform()) * SIM_INTERVAL_MS * 1000.0);
+}
+
+/* Any frame on air during [from, to), ignoring ring entry skip */
+static bool channel_active(int64_t from, int64_t to, int64_t airtime_us, uint32_t skip)
+{
+    for (uint32_t i = s_tx_count; i-- > 0 && s_tx_count - i <= SIM_TX_RING;) {
+        const tx_t *t = &s_tx[i % SIM_TX_RING];
+        if (t->start_us + airtime_us <= from) {
+            break;      /* Ring is in start order; older ones ended too */
+        }
+        if (i != skip && t->start_us < to && t->end_us > from) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void run(uint32_t n_nodes, bool lbt, result_t *r)
+{
+    airtime_params_t p = {
+        .sf = SIM_SF, .bw_hz = 125000, .cr = 1, .preamble = LORA_STANDARD_PREAMBLE,
+        .implicit_header = false, .crc_on = true,
+    };
+    const int64_t airtime_us = airtime_lora_us(&p, SIM_FRAME_BYTES);
+    const int64_t symbol_us  = ((int64_t)1000000 << SIM_SF) / 125000;
+    const int64_t cad_us     = (LORA_CAD_SYMBOLS(SIM_SF) + 1) * symbol_us;
+    const int64_t end_us     = (int64_t)SIM_DURATION_MS * 1000;
+
+    s_rng = 0x9E3779B97F4A7C15ULL;
+    s_tx_count = 0;
+    for (uint32_t i = 0; i < n_nodes; i++) {
+        s_nodes[i] = (node_t){ .state = NODE_IDLE, .next_arrival_us = exp_interval_us(),
+                               .next_action_us = INT64_MAX };
+    }
+
+    int64_t busy_until = 0;
+    for (;;) {
+        /* Earliest event over all nodes */
+        int64_t now = INT64_MAX;
+        node_t *n = NULL;
+        bool arrival = false;
+        for (uint32_t i = 0; i < n_nodes; i++) {
+            if (s_nodes[i].next_arrival_us < now) {
+                now = s_nodes[i].next_arrival_us; n = &s_nodes[i]; arrival = true;
+            }
+            if (s_nodes[i].next_action_us < now) {
+                now = s_nodes[i].next_action_us; n = &s_nodes[i]; arrival = false;
+            }
+        }
+        if (now >= end_us) {
+            break;
+        }
+
+        if (arrival) {
+            r->generated++;
+            n->next_arrival_us = now + exp_interval_us();
+            if (n->pending == SIM_QUEUE_MAX) {
+                r->overflow++;
+                continue;
+            }
+            if (n->pending++ == 0) {
+                n->head_since_us  = now;
+                n->state          = NODE_ATTEMPT;
+                n->next_action_us = now;
+            }
+            continue;
+        }
+
+        switch (n->state) {
+        case NODE_ATTEMPT:
+            if (lbt) {
+                n->state          = NODE_CAD;
+                n->cad_start_us   = now;
+                n->next_action_us = now + cad_us;
+                break;
+            }
+            /* ALOHA sends straight away */
+            /* fall through */
+        case NODE_CAD: {
+            if (n->state == NODE_CAD &&
+                channel_active(n->cad_start_us, now, airtime_us, UINT32_MAX) &&
+                uniform() < SIM_CAD_DETECT) {
+                if (++n->busy < LORA_LBT_MAX_ATTEMPTS) {
+                    uint8_t exp = n->busy < LORA_LBT_BACKOFF_MAX_EXP
+                                ? n->busy : LORA_LBT_BACKOFF_MAX_EXP;
+                    uint32_t slots = 1 + (uint32_t)(uniform() * (1u << exp));
+                    n->state          = NODE_ATTEMPT;
+                    n->next_action_us = now + (int64_t)slots * LORA_LBT_BACKOFF_SLOT_MS * 1000;
+                    break;
+                }
+                r->forced++;
+            }
+            int64_t start = now + (lbt ? SIM_TURNAROUND_US : 0);
+            n->tx_slot = s_tx_count;
+            s_tx[s_tx_count++ % SIM_TX_RING] = (tx_t){ start, start + airtime_us };
+            r->busy_us += (double)(start + airtime_us - (start > busy_until ? start : busy_until));
+            if (start + airtime_us > busy_until) {
+                busy_until = start + airtime_us;
+            }
+            n->state          = NODE_TX;
+            n->next_action_us = start + airtime_us;
+            break;
+        }
+        case NODE_TX: {
+            const tx_t *t = &s_tx[n->tx_slot % SIM_TX_RING];
+            if (!channel_active(t->start_us, t->end_us, airtime_us, n->tx_slot)) {
+                r->delivered++;
+                r->latency_ms += (now - n->head_since_us) / 1000.0;
+            }
+            n->busy = 0;
+            if (--n->pending > 0) {
+                n->head_since_us  = now;
+                n->state          = NODE_ATTEMPT;
+                n->next_action_us = now;
+            } else {
+                n->state          = NODE_IDLE;
+                n->next_action_us = INT64_MAX;
+            }
+            break;
+        }
+        default:
+            n->next_action_us = INT64_MAX;
+            break;
+        }
+    }
+}
+
+int main(void)
+{
+    airtime_params_t p = {
+        .sf = SIM_SF, .bw_hz = 125000, .cr = 1, .preamble = LORA_STANDARD_PREAMBLE,
+        .implicit_header = false, .crc_on = true,
+    };
+    double airtime_ms = airtime_lora_us(&p, SIM_FRAME_BYTES) / 1000.0;
+
+    printf("LBT simulation: SF%d, %d B frames (%.1f ms), one event per node every "
+           "%d s on average, %d min\n", SIM_SF, SIM_FRAME_BYTES, airtime_ms,
+           SIM_INTERVAL_MS / 1000, SIM_DURATION_MS / 60000);
+    printf("CAD %d symbols, detect p=%.2f, backoff slot %d ms, max %d CADs\n\n",
+           LORA_CAD_SYMBOLS(SIM_SF), SIM_CAD_DETECT, LORA_LBT_BACKOFF_SLOT_MS,
+           LORA_LBT_MAX_ATTEMPTS);
+
+    printf("%6s %8s | %10s %9s | %10s %9s %16s %8s\n", "nodes", "load G",
+           "ALOHA del", "chan use", "LBT del", "chan use", "head-of-queue ms", "forced");
+
+    const uint32_t counts[] = { 10, 50, 100, 200, 500, 1000 };
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        result_t aloha = {0}, lbt = {0};
+        run(counts[i], false, &aloha);
+        run(counts[i], true, &lbt);
+
+        double load = counts[i] * airtime_ms / SIM_INTERVAL_MS;
+        double span = (double)SIM_DURATION_MS * 1000.0;
+        printf("%6u %8.2f | %9.1f%% %8.1f%% | %9.1f%% %8.1f%% %16.1f %7.2f%%\n",
+               counts[i], load,
+               100.0 * aloha.delivered / aloha.generated, 100.0 * aloha.busy_us / span,
+               100.0 * lbt.delivered / lbt.generated, 100.0 * lbt.busy_us / span,
+               lbt.delivered ? lbt.latency_ms / lbt.delivered : 0.0,
+               lbt.generated ? 100.0 * lbt.forced / lbt.generated : 0.0);
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+/**
+ * Host microbenchmark for the packet codec
+ *
+ * Reports packets/second for each stage the firmware runs per event:
+ * build, serialize, deserialize and validate, plus the single-pass
+ * encode/decode path and the v2/compact frames for comparison.
+ *
+ * Build: see tools/CMakeLists.txt
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "packet.h"
+
+#define BENCH_PACKETS  2000000
+
+/* Keeps the compiler from discarding benchmarked work */
+static volatile uint32_t s_sink;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, double t0, double t1)
+{
+    printf("%-22s %12.0f pkt/s %9.1f ns/pkt\n", name,
+           BENCH_PACKETS / (t1 - t0), (t1 - t0) * 1e9 / BENCH_PACKETS);
+}
+
+int main(void)
+{
+    lora_packet_t pkt;
+    uint8_t       buf[PACKET_MAX_FRAME_SIZE];
+    double        t0, t1;
+
+    /* Build only fills fields; the CRC is paid when the frame is written */
+    t0 = now_s();
+    for (uint32_t i = 0; i < BENCH_PACKETS; i++) {
+        packet_build(&pkt, (uint8_t)i, i, EVENT_PIR_MOTION, 87);
+        packet_serialize(&pkt, buf);
+        s_sink += buf[8];
+    }
+    report("build + serialize", t0, now_s());
+
+    t0 = now_s();
+    for (uint32_t i = 0; i < BENCH_PACKETS; i++) {
+        pkt.timestamp = i;
+        packet_serialize(&pkt, buf);
+        s_sink += buf[2];
+    }
+    report("packet_serialize", t0, now_s());
+
+    packet_build(&pkt, 0x01, 123456, EVENT_PIR_MOTION, 87);
+    packet_encode(&pkt, buf);
+
+    lora_packet_t out;
+    t0 = now_s();
+    for (uint32_t i = 0; i < BENCH_PACKETS; i++) {
+        packet_deserialize(buf, &out);
+        s_sink += out.crc;
+    }
+    report("packet_deserialize", t0, now_s());
+
+    t0 = now_s();
+    for (uint32_t i = 0; i < BENCH_PACKETS; i++) {
+        s_sink += packet_validate(&out);
+    }
+    report("packet_validate", t0, now_s());
+
+    /* Single-pass paths the services use */
+    t0 = now_s();
+    for (uint32_t i = 0; i < BENCH_PACKETS; i++) {
+        pkt.timestamp = i;
+        s_sink += packet_encode(&pkt, buf);
+    }
+    report("packet_encode", t0, now_s());
+
+    packet_encode(&pkt, buf);
+    t0 = now_s();
+    for (uint32_t i = 0; i < BENCH_PACKETS; i++) {
+        s_sink += packet_decode(buf, PACKET_SIZE, &out);
+    }
+    report("packet_decode", t0, now_s());
+
+    pkt.seq     = 42;
+    pkt.has_seq = true;
+    uint8_t len = 0;
+    t0 = now_s();
+    for (uint32_t i = 0; i < BENCH_PACKETS; i++) {
+        pkt.timestamp = i;
+        len = packet_v2_encode(&pkt, NULL, 0, buf);
+        s_sink += len;
+    }
+    t1 = now_s();
+    report("packet_v2_encode", t0, t1);
+
+    t0 = now_s();
+    for (uint32_t i = 0; i < BENCH_PACKETS; i++) {
+        s_sink += packet_decode_any(buf, len, &out);
+    }
+    report("packet_decode_any(v2)", t0, now_s());
+
+    t0 = now_s();
+    for (uint32_t i = 0; i < BENCH_PACKETS; i++) {
+        pkt.timestamp = i * PACKET_COMPACT_TS_RES_MS;
+        len = packet_compact_encode(&pkt, 1, buf);
+        s_sink += len;
+    }
+    report("packet_compact_encode", t0, now_s());
+
+    t0 = now_s();
+    for (uint32_t i = 0; i < BENCH_PACKETS; i++) {
+        s_sink += packet_compact_decode(buf, len, &out);
+    }
+    report("packet_compact_decode", t0, now_s());
+
+    return 0;
+}
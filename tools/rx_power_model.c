@@ -0,0 +1,92 @@
+/**
+ * Duty-cycled receive: average radio current vs. wake preamble length
+ *
+ * For each SF and transmitter preamble, takes the listen/sleep periods
+ * the driver programs with LORA_RX_DUTY_CYCLE (airtime_rx_duty_cycle())
+ * and prints the receiver's average SX1262 current, idle and with
+ * SIM_FRAMES_PER_HOUR frames arriving, against continuous RX. The price
+ * is paid by the transmitters: extra airtime and energy per frame, and
+ * the same extra delivery latency.
+ *
+ * Radio only; the ESP32 on the receiver is not included.
+ *
+ * Build: see tools/CMakeLists.txt (needs the transmitter's lora_driver.h
+ * for the duty-cycle constants)
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include "lora_driver.h"
+#include "airtime.h"
+
+#define SIM_FRAME_BYTES      12        /* v2 single-event frame          */
+#define SIM_FRAMES_PER_HOUR  120       /* All nodes, at the receiver     */
+#define SIM_SUPPLY_V         3.3
+
+/* SX1262 datasheet figures, DC-DC, BW125 */
+#define SIM_RX_MA            4.6
+#define SIM_SLEEP_MA         0.0012    /* Warm sleep with the RTC timer  */
+#define SIM_WAKE_MA          2.0       /* TCXO + STDBY_XOSC start-up     */
+#define SIM_WAKE_US          1000      /* SX_RXDC_WAKE_US in the driver  */
+#define SIM_TX_MA            100.0     /* +20 dBm                        */
+
+static double airtime_ms(uint8_t sf, uint16_t preamble)
+{
+    airtime_params_t p = {
+        .sf = sf, .bw_hz = 125000, .cr = 1, .preamble = preamble,
+        .implicit_header = false, .crc_on = true,
+    };
+    return airtime_lora_us(&p, SIM_FRAME_BYTES) / 1000.0;
+}
+
+int main(void)
+{
+    const uint16_t preambles[] = { 32, 64, LORA_WAKE_PREAMBLE, 256, 512 };
+    const int n_pre = sizeof(preambles) / sizeof(preambles[0]);
+
+    printf("Duty-cycled RX: %d-symbol listen window, %d us wake-up, %d B frames, "
+           "%d frames/h\n", LORA_RXDC_RX_SYMBOLS, SIM_WAKE_US, SIM_FRAME_BYTES,
+           SIM_FRAMES_PER_HOUR);
+    printf("Continuous RX: %.0f uA\n\n", SIM_RX_MA * 1000.0);
+
+    printf("%4s %8s | %9s %9s %9s %11s %8s | %11s %11s\n", "SF", "preamble",
+           "listen ms", "sleep ms", "idle uA", "loaded uA", "vs cont",
+           "TX +ms/frm", "TX +mJ/frm");
+
+    for (uint8_t sf = 7; sf <= 12; sf++) {
+        for (int i = 0; i < n_pre; i++) {
+            airtime_params_t p = {
+                .sf = sf, .bw_hz = 125000, .cr = 1, .preamble = preambles[i],
+                .implicit_header = false, .crc_on = true,
+            };
+            uint32_t rx_us, sleep_us;
+            airtime_rx_duty_cycle(&p, LORA_RXDC_RX_SYMBOLS, SIM_WAKE_US, &rx_us, &sleep_us);
+            if (sleep_us == 0) {
+                printf("%4u %8u | %9s\n", sf, preambles[i], "too short to sleep");
+                continue;
+            }
+
+            double cycle_us = SIM_WAKE_US + rx_us + (double)sleep_us;
+            double idle_ma  = (SIM_WAKE_US * SIM_WAKE_MA + rx_us * SIM_RX_MA +
+                               sleep_us * SIM_SLEEP_MA) / cycle_us;
+
+            /* A caught frame: on average half the preamble is left, then
+             * the payload, all at RX current instead of cycling */
+            double frame_ms = airtime_ms(sf, preambles[i]);
+            double pre_ms   = frame_ms - airtime_ms(sf, 0);
+            double busy_ms  = frame_ms - pre_ms / 2.0;
+            double busy_h   = busy_ms * SIM_FRAMES_PER_HOUR / 3600000.0;
+            double load_ma  = idle_ma * (1.0 - busy_h) + SIM_RX_MA * busy_h;
+
+            double extra_ms = frame_ms - airtime_ms(sf, LORA_STANDARD_PREAMBLE);
+            double extra_mj = extra_ms * SIM_TX_MA * SIM_SUPPLY_V / 1000.0;
+
+            printf("%4u %8u | %9.2f %9.1f %9.0f %11.0f %7.1f%% | %11.1f %11.2f\n",
+                   sf, preambles[i], rx_us / 1000.0, sleep_us / 1000.0,
+                   idle_ma * 1000.0, load_ma * 1000.0, 100.0 * load_ma / SIM_RX_MA,
+                   extra_ms, extra_mj);
+        }
+    }
+
+    printf("\nTX +ms/frm is also the extra delivery latency per frame\n");
+    return 0;
+}
@@ -1,7 +1,11 @@
 #include "event_service.h"
 #include "packet.h"
+#include "seq_tracker.h"
 #include "power_driver.h"
 #include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_sleep.h"
+#include "nvs.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 #include "esp_timer.h"
@@ -11,10 +15,56 @@ static const char *TAG = "EVENT_SERVICE";
 /* Internal event queue */
 static QueueHandle_t s_event_queue = NULL;
 
+/* Rolling per-node sequence number, one per built packet. Kept in RTC
+ * memory across deep sleep, and resumed from the limit saved in NVS
+ * after a reset, so the receiver never sees a number twice. */
+static RTC_DATA_ATTR seq_sender_t s_seq;
+static RTC_DATA_ATTR uint32_t s_seq_magic;
+#define SEQ_MAGIC         0x53455143   /* "SEQC" */
+#define SEQ_NVS_NAMESPACE "event"
+#define SEQ_NVS_KEY       "seq_limit"
+
+static uint16_t event_service_seq_load(void)
+{
+    nvs_handle_t nvs;
+    uint16_t limit = 0;
+    if (nvs_open(SEQ_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return 0;       /* Namespace not created yet: first boot */
+    }
+    if (nvs_get_u16(nvs, SEQ_NVS_KEY, &limit) != ESP_OK) {
+        limit = 0;
+    }
+    nvs_close(nvs);
+    return limit;
+}
+
+static void event_service_seq_save(uint16_t limit)
+{
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(SEQ_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err == ESP_OK) {
+        err = nvs_set_u16(nvs, SEQ_NVS_KEY, limit);
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs);
+        }
+        nvs_close(nvs);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Sequence limit not saved: %s", esp_err_to_name(err));
+    }
+}
+
 void event_service_init(void)
 {
     s_event_queue = xQueueCreate(EVENT_QUEUE_SIZE, sizeof(uint8_t));
-    ESP_LOGI(TAG, "Event service initialized, queue size: %d", EVENT_QUEUE_SIZE);
+
+    if (s_seq_magic != SEQ_MAGIC ||
+        esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_UNDEFINED) {
+        seq_sender_resume(&s_seq, event_service_seq_load());
+        s_seq_magic = SEQ_MAGIC;
+    }
+    ESP_LOGI(TAG, "Event service initialized, queue size: %d, next seq %u",
+             EVENT_QUEUE_SIZE, s_seq.next);
 }
 
 void event_service_push(uint8_t event_type)
@@ -44,9 +94,13 @@ bool event_service_build_packet(lora_packet_t *pkt, uint8_t node_id)
 
     /* Build packet with CRC */
     packet_build(pkt, node_id, timestamp, event_type, battery);
+    if (seq_sender_next(&s_seq, &pkt->seq)) {
+        event_service_seq_save(s_seq.limit);
+    }
+    pkt->has_seq = true;
 
-    ESP_LOGI(TAG, "Packet built - node:%d event:0x%02X batt:%d%%",
-             node_id, event_type, battery);
+    ESP_LOGI(TAG, "Packet built - node:%d seq:%u event:0x%02X batt:%d%%",
+             node_id, pkt->seq, event_type, battery);
 
     return true;
 }
\ No newline at end of file
@@ -1,14 +1,236 @@
 #include "lora_service.h"
 #include "lora_driver.h"
 #include "packet.h"
+#include "fec.h"
+#include "arq.h"
+#include "adr.h"
+#include "duty_cycle.h"
+#include "hop.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "esp_sleep.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 
 static const char *TAG = "LORA_SERVICE";
 
+#if LORA_PROFILE == LORA_PROFILE_LOW_AIRTIME
+/* Implicit header: every frame on air must be LORA_IMPLICIT_PACKET_SIZE */
+#if LORA_SERVICE_TX_FORMAT == LORA_TX_FORMAT_LEGACY
+#define LORA_SERVICE_FRAME_SIZE  PACKET_SIZE
+#elif LORA_SERVICE_TX_FORMAT == LORA_TX_FORMAT_COMPACT
+#define LORA_SERVICE_FRAME_SIZE  (PACKET_COMPACT_CORE_SIZE + LORA_SERVICE_COMPACT_CRC_BYTES)
+#else
+#error "Low-airtime profile needs a fixed-length TX format (legacy or compact)"
+#endif
+#if LORA_SERVICE_FRAME_SIZE + FEC_LINK_PARITY_BYTES != LORA_IMPLICIT_PACKET_SIZE
+#error "LORA_IMPLICIT_PACKET_SIZE does not match the TX format + FEC parity"
+#endif
+#if ARQ_LINK_ENABLED
+#error "ARQ ACKs are not fixed-size frames; disable ARQ for the low-airtime profile"
+#endif
+#if ADR_LINK_ENABLED
+#error "ADR commands are not fixed-size frames; disable ADR for the low-airtime profile"
+#endif
+#endif
+
+/* lora_tx_task and power_task (sleep on critical battery) both drive
+ * the radio; the driver is only safe from one task at a time */
+static SemaphoreHandle_t s_radio_lock = NULL;
+
+/* Frames whose TX never completed (timeout / radio error) */
+static uint32_t s_tx_failed = 0;
+
+/* Airtime budget and counters, charged as each frame goes on air. Kept
+ * in RTC memory so deep sleep cycles cannot refill it for free. */
+static RTC_DATA_ATTR duty_cycle_t s_budget;
+static RTC_DATA_ATTR uint32_t s_budget_magic;
+#define BUDGET_MAGIC  0x44435942   /* "DCYB" */
+
+#if LORA_HOP_TX
+/* Frames sent: position in this node's hop sequence, kept across deep
+ * sleep so every wake does not start on the same channel */
+static RTC_DATA_ATTR uint32_t s_hop_index;
+#endif
+
+#if ADR_LINK_ENABLED
+/* Last command heard for us, applied once the listen window closes */
+static packet_adr_t s_adr_pending;
+static bool s_adr_have = false;
+
+/* Frames since we last heard the receiver at all */
+static uint8_t s_adr_silent = 0;
+
+/* Configuration to revert to when the downlink goes quiet */
+static lora_radio_config_t s_adr_base;
+#endif
+
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+/* Time-on-air of a frame of this length before FEC parity */
+static uint32_t lora_service_airtime_us(uint8_t length)
+{
+    return lora_driver_airtime_us(LORA_PROFILE, length + FEC_LINK_PARITY_BYTES);
+}
+
+/* Collect the frame on air, if any (caller holds s_radio_lock) */
+static bool lora_service_collect(void)
+{
+    lora_tx_result_t result;
+    if (!lora_driver_tx_wait(&result, portMAX_DELAY)) {
+        return true;   /* Nothing on air */
+    }
+    if (result.status != LORA_TX_OK) {
+        s_tx_failed++;
+        return false;
+    }
+    return true;
+}
+
+/* Append link FEC parity (if enabled) and start the frame on air, on
+ * node_id's next hop channel with LORA_HOP_TX. The previous frame is
+ * collected first, so callers encode the next frame while the radio is
+ * still transmitting the last one. */
+static bool lora_service_transmit(uint8_t node_id, uint8_t *buffer, uint8_t length)
+{
+    uint32_t airtime_us = lora_service_airtime_us(length);
+#if DUTY_CYCLE_MAX_DWELL_MS > 0
+    if (airtime_us > DUTY_CYCLE_MAX_DWELL_MS * 1000UL) {
+        ESP_LOGE(TAG, "Frame of %d bytes exceeds dwell limit (%lu us on air)",
+                 length, (unsigned long)airtime_us);
+        return false;
+    }
+#endif
+#if FEC_LINK_PARITY_BYTES > 0
+    length = fec_encode(buffer, length, FEC_LINK_PARITY_BYTES);
+    if (length == 0) {
+        ESP_LOGE(TAG, "Frame too long for FEC parity");
+        return false;
+    }
+#endif
+    lora_service_collect();
+#if LORA_HOP_TX
+    /* Retries hop too: a channel that just failed gets a rest */
+    lora_driver_set_channel(hop_channel(node_id, s_hop_index++, LORA_HOP_CHANNELS));
+#else
+    (void)node_id;
+#endif
+    if (!lora_driver_send_async(buffer, length)) {
+        return false;
+    }
+    duty_cycle_consume(&s_budget, airtime_us, now_ms());
+    return true;
+}
+
+/* Start a fresh budget at power-on. After deep sleep carry the old one
+ * over: esp_timer restarted, so rebase its clock without crediting the
+ * (unknown) sleep time - conservative, never over budget. */
+static void lora_service_budget_resume(void)
+{
+    if (s_budget_magic == BUDGET_MAGIC &&
+        esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_UNDEFINED) {
+        s_budget.last_ms   = now_ms();
+        s_budget.deferring = false;
+        return;
+    }
+    duty_cycle_init(&s_budget, now_ms());
+    s_budget_magic = BUDGET_MAGIC;
+}
+
+/* Encode one event in the configured single-event format */
+static uint8_t lora_service_encode_single(const lora_packet_t *pkt, uint8_t *buffer)
+{
+#if LORA_SERVICE_TX_FORMAT == LORA_TX_FORMAT_V2
+    return packet_v2_encode(pkt, NULL, 0, buffer);
+#elif LORA_SERVICE_TX_FORMAT == LORA_TX_FORMAT_COMPACT
+    return packet_compact_encode(pkt, LORA_SERVICE_COMPACT_CRC_BYTES, buffer);
+#else
+    return packet_encode(pkt, buffer);
+#endif
+}
+
+/* Aggregate a batch when the frame format, sequence numbers and dwell
+ * limit allow it; 0 means the batch goes out one event per frame */
+static uint8_t lora_service_encode_batch(const lora_packet_t *pkts, uint8_t count,
+                                         uint8_t *buffer)
+{
+#if LORA_PROFILE == LORA_PROFILE_LOW_AIRTIME
+    /* Aggregated frames vary in size - implicit header cannot carry them */
+    (void)pkts;
+    (void)count;
+    (void)buffer;
+    return 0;
+#else
+    uint8_t length = packet_aggregate_encode(pkts, count, buffer, PACKET_AGG_MAX_SIZE);
+#if DUTY_CYCLE_MAX_DWELL_MS > 0
+    if (length > 0 && lora_service_airtime_us(length) > DUTY_CYCLE_MAX_DWELL_MS * 1000UL) {
+        return 0;
+    }
+#endif
+    return length;
+#endif
+}
+
+bool lora_service_flush(void)
+{
+    xSemaphoreTake(s_radio_lock, portMAX_DELAY);
+    bool ok = lora_service_collect();
+    xSemaphoreGive(s_radio_lock);
+    return ok;
+}
+
+uint32_t lora_service_get_tx_failed(void)
+{
+    return s_tx_failed;
+}
+
+void lora_service_sleep(void)
+{
+    /* Waits out whatever lora_tx_task is doing with the radio, and is
+     * never given back: nothing may wake the radio before deep sleep */
+    xSemaphoreTake(s_radio_lock, portMAX_DELAY);
+    lora_service_collect();
+    lora_driver_sleep();
+}
+
+bool lora_service_set_radio_config(const lora_radio_config_t *cfg, bool persist)
+{
+    /* The driver refuses to retune with a frame on air */
+    xSemaphoreTake(s_radio_lock, portMAX_DELAY);
+    lora_service_collect();
+    bool ok = lora_driver_set_config(cfg);
+#if ADR_LINK_ENABLED
+    if (ok) {
+        s_adr_base = *cfg;
+    }
+#endif
+    xSemaphoreGive(s_radio_lock);
+    return ok && (!persist || lora_driver_config_save(cfg));
+}
+
 bool lora_service_init(void)
 {
+    if (s_radio_lock == NULL) {
+        s_radio_lock = xSemaphoreCreateMutex();
+        if (s_radio_lock == NULL) {
+            ESP_LOGE(TAG, "No memory for radio lock");
+            return false;
+        }
+    }
+
     bool ok = lora_driver_init();
     if (ok) {
+        /* Where radio bring-up spent its time waiting on BUSY */
+        lora_driver_log_busy_stats();
+#if ADR_LINK_ENABLED
+        lora_driver_get_config(&s_adr_base);
+#endif
+        lora_service_budget_resume();
         ESP_LOGI(TAG, "LoRa service ready");
     } else {
         ESP_LOGE(TAG, "LoRa service failed to initialize");
@@ -16,50 +238,254 @@ bool lora_service_init(void)
     return ok;
 }
 
-bool lora_service_send_packet(const lora_packet_t *pkt)
+/* Encode and start one single-event frame (caller holds s_radio_lock) */
+static bool lora_service_send_single(const lora_packet_t *pkt)
 {
-    uint8_t buffer[LORA_PACKET_SIZE];
+    uint8_t buffer[PACKET_V2_MAX_SIZE + FEC_MAX_PARITY];
 
-    /* Serialize struct to raw bytes */
-    packet_serialize(pkt, buffer);
+    /* Encode payload + CRC straight into the wire buffer */
+    uint8_t length = lora_service_encode_single(pkt, buffer);
+
+    if (length == 0) {
+        ESP_LOGE(TAG, "Cannot encode packet - event:0x%02X", pkt->event_type);
+        return false;
+    }
 
     /* Transmit over LoRa */
-    bool ok = lora_driver_send(buffer, LORA_PACKET_SIZE);
+    bool ok = lora_service_transmit(pkt->node_id, buffer, length);
 
     if (ok) {
-        ESP_LOGI(TAG, "Packet transmitted - node:%d event:0x%02X",
+        ESP_LOGI(TAG, "Packet queued on air - node:%d event:0x%02X",
                  pkt->node_id, pkt->event_type);
     }
 
     return ok;
 }
 
-bool lora_service_receive_packet(lora_packet_t *pkt)
+bool lora_service_send_packet(const lora_packet_t *pkt)
 {
-    if (!lora_driver_available()) {
-        return false;
+    xSemaphoreTake(s_radio_lock, portMAX_DELAY);
+    bool ok = lora_service_send_single(pkt);
+    xSemaphoreGive(s_radio_lock);
+    return ok;
+}
+
+/* Aggregate and start a batch (caller holds s_radio_lock) */
+static bool lora_service_send_frames(const lora_packet_t *pkts, uint8_t count)
+{
+    /* A lone event is cheaper as a single-event frame */
+    if (count == 1) {
+        return lora_service_send_single(&pkts[0]);
+    }
+
+    uint8_t buffer[PACKET_AGG_MAX_SIZE + FEC_MAX_PARITY];
+    uint8_t length = lora_service_encode_batch(pkts, count, buffer);
+    if (length == 0) {
+        /* Sequence gap (dropped from the queue), fixed-size profile or
+         * dwell limit - send events one by one */
+        ESP_LOGW(TAG, "Cannot aggregate batch of %d events, sending singly", count);
+        bool all_ok = true;
+        for (uint8_t i = 0; i < count; i++) {
+            all_ok &= lora_service_send_single(&pkts[i]);
+        }
+        return all_ok;
     }
 
-    uint8_t buffer[LORA_PACKET_SIZE];
-    uint8_t received = lora_driver_receive(buffer, LORA_PACKET_SIZE);
+    bool ok = lora_service_transmit(pkts[0].node_id, buffer, length);
 
-    if (received != LORA_PACKET_SIZE) {
-        ESP_LOGW(TAG, "Unexpected packet size: %d", received);
-        return false;
+    if (ok) {
+        ESP_LOGI(TAG, "Batch queued on air - node:%d events:%d bytes:%d",
+                 pkts[0].node_id, count, length);
+    }
+
+    return ok;
+}
+
+bool lora_service_send_batch(const lora_packet_t *pkts, uint8_t count)
+{
+    xSemaphoreTake(s_radio_lock, portMAX_DELAY);
+    bool ok = lora_service_send_frames(pkts, count);
+    xSemaphoreGive(s_radio_lock);
+    return ok;
+}
+
+/* Keep the receiver open until timeout_ms after our frame has left the
+ * antenna. ADR commands for node_id are kept for lora_service_adr_update().
+ * Returns on an ACK for node_id, or (ack == NULL) on an ADR command. */
+static bool lora_service_listen(uint8_t node_id, uint32_t timeout_ms, packet_ack_t *ack)
+{
+    uint8_t buffer[PACKET_ACK_SIZE + FEC_MAX_PARITY];
+    /* The window opens when our frame has left the antenna */
+    lora_service_collect();
+
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+
+    lora_driver_listen();
+
+    int64_t now;
+    while ((now = esp_timer_get_time()) < deadline) {
+        /* Sleep on DIO1 instead of polling the IRQ register */
+        uint32_t remaining_ms = (uint32_t)((deadline - now + 999) / 1000);
+        if (!lora_driver_wait_irq(remaining_ms)) {
+            break;
+        }
+        if (lora_driver_available()) {
+            uint8_t received = lora_driver_receive(buffer, sizeof(buffer), NULL);
+#if FEC_LINK_PARITY_BYTES > 0
+            if (fec_decode(buffer, received, FEC_LINK_PARITY_BYTES) < 0) {
+                continue;
+            }
+            received -= FEC_LINK_PARITY_BYTES;
+#endif
+#if ADR_LINK_ENABLED
+            packet_adr_t cmd;
+            if (packet_adr_decode(buffer, received, &cmd) && cmd.node_id == node_id) {
+                s_adr_pending = cmd;
+                s_adr_have    = true;
+                if (ack == NULL) {
+                    lora_driver_standby();
+                    return true;
+                }
+                continue;
+            }
+#endif
+            /* Ignore frames meant for other nodes and keep listening */
+            if (ack != NULL && packet_ack_decode(buffer, received, ack) &&
+                ack->node_id == node_id) {
+                lora_driver_standby();
+                return true;
+            }
+        }
+    }
+
+    lora_driver_standby();
+    return false;
+}
+
+#if ADR_LINK_ENABLED
+/* Run once per listen window. heard = the receiver answered at all. */
+static void lora_service_adr_update(bool heard)
+{
+    lora_radio_config_t cfg;
+    lora_driver_get_config(&cfg);
+
+    if (s_adr_have) {
+        s_adr_have   = false;
+        s_adr_silent = 0;
+        if (ADR_ADAPT_SF) {
+            cfg.spreading_factor = s_adr_pending.sf;
+        }
+        cfg.tx_power_dbm = s_adr_pending.tx_power_dbm;
+        if (!lora_driver_config_valid(&cfg)) {
+            ESP_LOGW(TAG, "ADR: ignoring SF%d %+d dBm", s_adr_pending.sf,
+                     s_adr_pending.tx_power_dbm);
+            return;
+        }
+        /* Not persisted: a reboot starts again from the base config */
+        if (lora_driver_set_config(&cfg)) {
+            ESP_LOGI(TAG, "ADR: now SF%d %+d dBm (margin %d dB)",
+                     cfg.spreading_factor, cfg.tx_power_dbm,
+                     s_adr_pending.margin_db);
+        }
+        return;
+    }
+
+    if (heard) {
+        s_adr_silent = 0;
+        return;
     }
 
-    /* Deserialize bytes into struct */
-    packet_deserialize(buffer, pkt);
+    /* The receiver confirms every ADR_CONFIRM_FRAMES; a long silence means
+     * we lost a command (or it moved SF without us): go back to base */
+    if (++s_adr_silent >= ADR_ACK_LIMIT) {
+        s_adr_silent = 0;
+        if (cfg.spreading_factor != s_adr_base.spreading_factor ||
+            cfg.tx_power_dbm != s_adr_base.tx_power_dbm) {
+            ESP_LOGW(TAG, "ADR: no downlink for %d frames, back to SF%d %+d dBm",
+                     ADR_ACK_LIMIT, s_adr_base.spreading_factor,
+                     s_adr_base.tx_power_dbm);
+            lora_driver_set_config(&s_adr_base);
+        }
+    }
+}
+#endif
+
+uint32_t lora_service_budget_wait_ms(const lora_packet_t *pkts, uint8_t count,
+                                     bool urgent)
+{
+    uint8_t buffer[PACKET_AGG_MAX_SIZE];
+    uint32_t airtime_us = 0;
+
+    /* Same framing decision lora_service_send_batch() will make */
+    uint8_t length = (count > 1) ? lora_service_encode_batch(pkts, count, buffer) : 0;
+    if (length > 0) {
+        airtime_us = lora_service_airtime_us(length);
+    } else {
+        for (uint8_t i = 0; i < count; i++) {
+            airtime_us += lora_service_airtime_us(lora_service_encode_single(&pkts[i], buffer));
+        }
+    }
+
+    return duty_cycle_wait_ms(&s_budget, airtime_us, urgent, now_ms());
+}
+
+void lora_service_get_airtime_stats(duty_cycle_t *stats)
+{
+    /* Refresh the bucket so the copy shows what is available now */
+    duty_cycle_available_us(&s_budget, now_ms());
+    *stats = s_budget;
+}
+
+bool lora_service_wait_ack(uint8_t node_id, packet_ack_t *ack, uint32_t timeout_ms)
+{
+    xSemaphoreTake(s_radio_lock, portMAX_DELAY);
+    bool ok = lora_service_listen(node_id, timeout_ms, ack);
+#if ADR_LINK_ENABLED
+    lora_service_adr_update(ok);
+#endif
+    xSemaphoreGive(s_radio_lock);
+    return ok;
+}
+
+bool lora_service_adr_window(uint8_t node_id)
+{
+#if ADR_LINK_ENABLED
+    xSemaphoreTake(s_radio_lock, portMAX_DELAY);
+    bool heard = lora_service_listen(node_id, ADR_RX_WINDOW_MS, NULL);
+    lora_service_adr_update(heard);
+    xSemaphoreGive(s_radio_lock);
+    return heard;
+#else
+    (void)node_id;
+    return false;
+#endif
+}
+
+bool lora_service_receive_packet(lora_packet_t *pkt)
+{
+    uint8_t buffer[PACKET_V2_MAX_SIZE];
+    lora_rx_meta_t meta;
+    uint8_t received = 0;
+
+    /* A pending TX_DONE must not be mistaken for a stray IRQ */
+    xSemaphoreTake(s_radio_lock, portMAX_DELAY);
+    lora_service_collect();
+    if (lora_driver_available()) {
+        received = lora_driver_receive(buffer, sizeof(buffer), &meta);
+    }
+    xSemaphoreGive(s_radio_lock);
+    if (received == 0) {
+        return false;
+    }
 
-    /* Validate CRC */
-    if (!packet_validate(pkt)) {
+    /* Validate CRC on the raw bytes, then deserialize into struct */
+    if (!packet_decode_any(buffer, received, pkt)) {
         ESP_LOGE(TAG, "CRC validation failed - packet corrupted");
         return false;
     }
 
     ESP_LOGI(TAG, "Valid packet - node:%d event:0x%02X batt:%d%% rssi:%d dBm",
-             pkt->node_id, pkt->event_type, pkt->battery_level,
-             lora_driver_rssi());
+             pkt->node_id, pkt->event_type, pkt->battery_level, meta.rssi_dbm);
 
     return true;
 }
\ No newline at end of file
@@ -4,6 +4,18 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "packet.h"
+#include "lora_driver.h"
+#include "duty_cycle.h"
+
+/* Wire format for single events - only v2 carries the sequence number */
+#define LORA_TX_FORMAT_LEGACY    0   /* 9-byte v1 frame                 */
+#define LORA_TX_FORMAT_V2        1   /* Versioned frame, 12+ bytes      */
+#define LORA_TX_FORMAT_COMPACT   2   /* Bit-packed frame, 5-7 bytes     */
+#define LORA_SERVICE_TX_FORMAT   LORA_TX_FORMAT_V2
+
+/* Compact frame CRC bytes: 2, 1, or 0. Fewer bytes lean on the radio
+ * CRC, which the receiver's driver checks (IRQ_CRC_ERR) */
+#define LORA_SERVICE_COMPACT_CRC_BYTES  2
 
 /**
  * @brief Initialize LoRa service (wraps lora_driver_init)
@@ -12,12 +24,103 @@
 bool lora_service_init(void);
 
 /**
- * @brief Serialize and transmit a lora_packet_t
+ * @brief Serialize and start transmitting a lora_packet_t
+ *
+ * Returns once the frame is on air; the previous frame's completion is
+ * collected first. Call lora_service_flush() to wait for this one.
+ *
  * @param pkt Packet to transmit
- * @return true if transmitted successfully
+ * @return true if the frame was handed to the radio
  */
 bool lora_service_send_packet(const lora_packet_t *pkt);
 
+/**
+ * @brief Start transmitting a batch of events in one aggregated frame
+ *
+ * Non-blocking like lora_service_send_packet().
+ *
+ * @param pkts  Packets to transmit, oldest first
+ * @param count Number of packets (1..PACKET_AGG_MAX_EVENTS)
+ * @return true if the frame was handed to the radio
+ */
+bool lora_service_send_batch(const lora_packet_t *pkts, uint8_t count);
+
+/**
+ * @brief How long a batch must wait for the airtime budget
+ *
+ * Prices the batch with the framing lora_service_send_batch() would
+ * use and the current modem settings. Non-urgent batches leave
+ * DUTY_CYCLE_RESERVE_MS of the budget for urgent ones. Sending anyway
+ * is not refused; every frame on air is charged.
+ *
+ * @param pkts   Packets to transmit, oldest first
+ * @param count  Number of packets
+ * @param urgent May spend the reserved part of the budget
+ * @return 0 to send now, else milliseconds until it fits
+ */
+uint32_t lora_service_budget_wait_ms(const lora_packet_t *pkts, uint8_t count,
+                                     bool urgent);
+
+/**
+ * @brief Get airtime used, frames sent and budget deferrals since init
+ * @param stats Destination copy (tokens_us = airtime available now)
+ */
+void lora_service_get_airtime_stats(duty_cycle_t *stats);
+
+/**
+ * @brief Wait for the frame on air (if any) to finish
+ * @return false if that frame timed out or failed in the radio
+ */
+bool lora_service_flush(void);
+
+/**
+ * @brief Number of frames that never completed on air since boot
+ */
+uint32_t lora_service_get_tx_failed(void);
+
+/**
+ * @brief Finish the frame on air and put the radio into warm-start sleep
+ *
+ * Call before ESP32 deep sleep so the next boot can skip radio reset and
+ * calibration. Safe from any task: it waits for the radio lock, which
+ * lora_tx_task holds per send or listen window, and keeps it, so nothing
+ * touches the radio again before deep sleep.
+ */
+void lora_service_sleep(void);
+
+/**
+ * @brief Retune the radio at runtime, optionally keeping it across reboots
+ * @param cfg     New configuration (see lora_radio_config_t)
+ * @param persist Also save it to NVS so the next boot loads it
+ * @return false if rejected by the driver or the NVS write failed
+ */
+bool lora_service_set_radio_config(const lora_radio_config_t *cfg, bool persist);
+
+/**
+ * @brief Listen for an ACK addressed to this node (ARQ mode)
+ *
+ * ADR commands for this node heard in the same window are applied too.
+ *
+ * @param node_id    This node's ID
+ * @param ack        Destination for the decoded ACK
+ * @param timeout_ms How long to keep the receiver open
+ * @return true if an ACK for node_id arrived in time
+ */
+bool lora_service_wait_ack(uint8_t node_id, packet_ack_t *ack, uint32_t timeout_ms);
+
+/**
+ * @brief Listen briefly for an ADR command after a frame (ADR without ARQ)
+ *
+ * A command for this node is applied (not persisted) once the window
+ * closes. Without any downlink for ADR_ACK_LIMIT frames the radio goes
+ * back to its base configuration. With ARQ, lora_service_wait_ack()
+ * does the same, so this is not needed.
+ *
+ * @param node_id This node's ID
+ * @return true if a command arrived (always false when ADR is off)
+ */
+bool lora_service_adr_window(uint8_t node_id);
+
 /**
  * @brief Check for incoming packet and deserialize it
  * @param pkt Destination packet
@@ -1,5 +1,6 @@
 #include "power_manager.h"
 #include "power_driver.h"
+#include "lora_service.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 
@@ -54,6 +55,9 @@ void power_manager_tick(void)
     uint8_t batt = power_driver_read_percent();
     if (batt < 5 && batt > 0) {
         ESP_LOGW(TAG, "Critical battery (%d%%)! Entering deep sleep...", batt);
+        /* Radio keeps its configuration for a fast wake; waits for
+         * lora_tx_task to finish with it first */
+        lora_service_sleep();
         power_driver_deep_sleep(POWER_DEEP_SLEEP_MS);
         return;
     }
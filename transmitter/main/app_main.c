@@ -3,7 +3,7 @@
  *
  * FreeRTOS tasks:
  *   event_task  (P5) - Reads PIR events from queue, builds lora_packet_t
- *   lora_tx_task(P4) - Serializes and transmits packets over LoRa
+ *   lora_tx_task(P4) - Batches queued packets and transmits them over LoRa
  *   power_task  (P3) - Monitors battery and manages sleep states
  */
 #include <stdio.h>
@@ -11,13 +11,18 @@
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "esp_log.h"
+#include "nvs_flash.h"
 #include "esp_timer.h"
+#include "esp_sleep.h"
 
 #include "lora_driver.h"
 #include "oled_driver.h"
 #include "pir_driver.h"
 #include "power_driver.h"
 #include "packet.h"
+#include "arq.h"
+#include "adr.h"
+#include "duty_cycle.h"
 #include "event_service.h"
 #include "lora_service.h"
 #include "display_service.h"
@@ -31,9 +36,22 @@ static const char *TAG = "TX_MAIN";
 static QueueHandle_t s_tx_queue = NULL;
 #define TX_QUEUE_SIZE  5
 
+/* Aggregation: max events per frame and max wait after the first one */
+#define TX_BATCH_MAX_EVENTS      8
+#define TX_BATCH_MAX_LATENCY_MS  250
+
+#if TX_BATCH_MAX_EVENTS > PACKET_AGG_MAX_EVENTS
+#error "TX_BATCH_MAX_EVENTS exceeds PACKET_AGG_MAX_EVENTS"
+#endif
+
 /* Packet counter */
 static uint32_t s_tx_count = 0;
 
+#if ARQ_LINK_ENABLED
+/* Frames sent but not yet acknowledged */
+static arq_window_t s_arq;
+#endif
+
 /* ─── PIR Callback (ISR context) ─────────────────────────────── */
 
 static void pir_motion_cb(void)
@@ -66,25 +84,146 @@ static void event_task(void *arg)
 
 /* ─── LoRa TX Task (Priority 4) ──────────────────────────────── */
 
+#if DUTY_CYCLE_ENABLED
+/* Motion events may spend the reserved airtime; heartbeats and battery
+ * reports wait for the budget to recover */
+static bool lora_tx_urgent(const lora_packet_t *pkts, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++) {
+        if (pkts[i].event_type == EVENT_PIR_MOTION) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Hold a batch the airtime budget cannot pay for yet. Events arriving
+ * meanwhile join it: one aggregated frame costs less airtime than
+ * several. Returns the final batch size. */
+static uint8_t lora_tx_wait_budget(lora_packet_t *batch, uint8_t count)
+{
+    uint32_t hold_ms;
+    while ((hold_ms = lora_service_budget_wait_ms(batch, count,
+                                                  lora_tx_urgent(batch, count))) > 0) {
+        TickType_t ticks = pdMS_TO_TICKS(hold_ms) + 1;
+        if (count < TX_BATCH_MAX_EVENTS) {
+            if (xQueueReceive(s_tx_queue, &batch[count], ticks) == pdTRUE) {
+                count++;
+            }
+        } else {
+            vTaskDelay(ticks);
+        }
+    }
+    return count;
+}
+#endif
+
+#if ARQ_LINK_ENABLED
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+/* Listen for the receiver's ACK right after a frame went out */
+static void lora_tx_collect_ack(void)
+{
+    packet_ack_t ack;
+    if (lora_service_wait_ack(NODE_ID, &ack, ARQ_ACK_TIMEOUT_MS)) {
+        uint8_t released = arq_on_ack(&s_arq, &ack);
+        ESP_LOGI(TAG, "ACK seq:%u released %d frame(s)", ack.ack_seq, released);
+    }
+}
+
+/* Resend only the frames whose backoff has expired */
+static void lora_tx_retransmit_due(void)
+{
+    arq_entry_t *e;
+    while ((e = arq_next_due(&s_arq, now_ms())) != NULL) {
+#if DUTY_CYCLE_ENABLED
+        /* Out of budget: push it back until the airtime is there */
+        uint32_t hold_ms = lora_service_budget_wait_ms(e->pkts, e->count,
+                                                       lora_tx_urgent(e->pkts, e->count));
+        if (hold_ms > 0) {
+            e->due_ms = now_ms() + hold_ms;
+            break;
+        }
+#endif
+        ESP_LOGW(TAG, "Retransmit seq:%u (%d events, retry %d)",
+                 e->pkts[0].seq, e->count, e->retries + 1);
+        lora_service_send_batch(e->pkts, e->count);
+        arq_mark_resent(&s_arq, e, now_ms());
+        lora_tx_collect_ack();
+    }
+}
+#endif
+
 static void lora_tx_task(void *arg)
 {
     ESP_LOGI(TAG, "LoRa TX task started");
 
+    lora_packet_t batch[TX_BATCH_MAX_EVENTS];
+
+#if ARQ_LINK_ENABLED
+    arq_init(&s_arq);
+#endif
+
     while (1) {
-        lora_packet_t pkt;
+        TickType_t wait = pdMS_TO_TICKS(1000);
+#if ARQ_LINK_ENABLED
+        /* Wake up in time for the next retransmission; one tick more so
+         * a wait under 10 ms is not truncated to a busy poll */
+        uint32_t due = arq_ms_until_due(&s_arq, now_ms());
+        if (due < 1000) {
+            wait = pdMS_TO_TICKS(due) + 1;
+        }
+#endif
 
         /* Block until a packet arrives */
-        if (xQueueReceive(s_tx_queue, &pkt, pdMS_TO_TICKS(1000)) == pdTRUE) {
-            bool ok = lora_service_send_packet(&pkt);
+        if (xQueueReceive(s_tx_queue, &batch[0], wait) == pdTRUE) {
+            /* Drain more events until the batch is full or the window closes */
+            uint8_t count = 1;
+            TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(TX_BATCH_MAX_LATENCY_MS);
+            while (count < TX_BATCH_MAX_EVENTS) {
+                TickType_t now = xTaskGetTickCount();
+                if ((int32_t)(deadline - now) <= 0) {
+                    break;
+                }
+                if (xQueueReceive(s_tx_queue, &batch[count], deadline - now) != pdTRUE) {
+                    break;
+                }
+                count++;
+            }
+
+#if DUTY_CYCLE_ENABLED
+            count = lora_tx_wait_budget(batch, count);
+#endif
+
+            /* Returns once on air - the next batch is collected meanwhile */
+            bool ok = lora_service_send_batch(batch, count);
 
             if (ok) {
-                s_tx_count++;
-                display_service_show_tx(&pkt, s_tx_count);
-                ESP_LOGI(TAG, "TX #%lu OK", s_tx_count);
+                s_tx_count += count;
+                display_service_show_tx(&batch[count - 1], s_tx_count);
+                ESP_LOGI(TAG, "TX #%lu on air (%d events)", s_tx_count, count);
+#if ARQ_LINK_ENABLED
+                arq_push(&s_arq, batch, count, now_ms());
+                lora_tx_collect_ack();
+#elif ADR_LINK_ENABLED
+                /* ARQ's ACK window carries ADR commands too; without it
+                 * listen briefly for the receiver's verdict */
+                lora_service_adr_window(NODE_ID);
+#endif
             } else {
                 ESP_LOGE(TAG, "TX FAILED");
             }
+        } else if (!lora_service_flush()) {
+            /* Queue idle: collect the last frame's result */
+            ESP_LOGE(TAG, "TX FAILED on air (%lu total)", lora_service_get_tx_failed());
         }
+
+#if ARQ_LINK_ENABLED
+        lora_tx_retransmit_due();
+#endif
     }
 }
 
@@ -106,6 +245,23 @@ static void power_task(void *arg)
             heartbeat_counter = 0;
             event_service_push(EVENT_HEARTBEAT);
 
+            /* Airtime metrics once a minute */
+            duty_cycle_t air;
+            lora_service_get_airtime_stats(&air);
+            ESP_LOGI(TAG, "Airtime: %lu ms in %lu frames, budget %ld ms, "
+                     "deferred %lu (%lu ms)",
+                     (unsigned long)(air.airtime_us / 1000), (unsigned long)air.frames,
+                     (long)(air.tokens_us / 1000),
+                     (unsigned long)air.deferred, (unsigned long)air.deferred_ms);
+#if LORA_LBT_ENABLED
+            lora_lbt_stats_t lbt;
+            lora_driver_get_lbt_stats(&lbt);
+            ESP_LOGI(TAG, "LBT: %lu/%lu CADs busy, %lu frames deferred (%lu ms), "
+                     "%lu forced", (unsigned long)lbt.cad_busy,
+                     (unsigned long)lbt.cad_runs, (unsigned long)lbt.deferred,
+                     (unsigned long)lbt.backoff_ms, (unsigned long)lbt.forced);
+#endif
+
             /* Check for low battery event */
             if (power_driver_is_low()) {
                 event_service_push(EVENT_LOW_BATTERY);
@@ -124,10 +280,21 @@ void app_main(void)
     ESP_LOGI(TAG, "=== LoRa IoT Node - Transmitter ===");
     ESP_LOGI(TAG, "Node ID: 0x%02X", NODE_ID);
 
-    /* Initialize display */
+    /* Initialize display; the splash only on a cold boot, a deep-sleep
+     * wake goes straight to the radio so the PIR event is not delayed */
     display_service_init();
-    display_service_show_boot(NODE_ID);
-    vTaskDelay(pdMS_TO_TICKS(1500));
+    if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_UNDEFINED) {
+        display_service_show_boot(NODE_ID);
+        vTaskDelay(pdMS_TO_TICKS(1500));
+    }
+
+    /* NVS holds the saved radio configuration */
+    esp_err_t nvs_err = nvs_flash_init();
+    if (nvs_err == ESP_ERR_NVS_NO_FREE_PAGES || nvs_err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_LOGW(TAG, "NVS partition reformatted");
+        nvs_flash_erase();
+        nvs_flash_init();
+    }
 
     /* Initialize LoRa */
     if (!lora_service_init()) {